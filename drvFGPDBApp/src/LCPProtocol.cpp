@@ -1,4 +1,10 @@
 #include <chrono>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include "LCPProtocol.h"
 
@@ -27,12 +33,190 @@ namespace LCP {
   }
 }
 
+//-----------------------------------------------------------------------------
+size_t LCPUtil::findChangedRegsScalar(const uint32_t *respVals,
+                                      const uint32_t *shadowVals, size_t count,
+                                      uint64_t *chgdBits)
+{
+  size_t numChgd = 0;
+
+  for (size_t w=0; w<(count + 63) / 64; ++w)  chgdBits[w] = 0;
+
+  for (size_t u=0; u<count; ++u)
+    if (respVals[u] != shadowVals[u])  {
+      chgdBits[u / 64] |= uint64_t(1) << (u % 64);  ++numChgd; }
+
+  return numChgd;
+}
+
+//-----------------------------------------------------------------------------
+//  Pick the version of findChangedRegs() for the CPU we are running on (once).
+//  The vector versions are built with target attributes, so they don't
+//  depend on the -m flags of the build.
+//-----------------------------------------------------------------------------
+size_t LCPUtil::findChangedRegs(const uint32_t *respVals,
+                                const uint32_t *shadowVals, size_t count,
+                                uint64_t *chgdBits)
+{
+  using FindFn = size_t (*)(const uint32_t *, const uint32_t *, size_t,
+                            uint64_t *);
+
+  static const FindFn findFn = [] () -> FindFn {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))  return findChangedRegsAVX2;
+    if (__builtin_cpu_supports("sse2"))  return findChangedRegsSSE2;
+#endif
+    return findChangedRegsScalar;
+  }();
+
+  return findFn(respVals, shadowVals, count, chgdBits);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+//-----------------------------------------------------------------------------
+//  Flag the registers left over after a vector loop (u is a multiple of 64 or
+//  of the vector width) and return the # of registers that changed
+//-----------------------------------------------------------------------------
+static size_t finishChangedRegs(const uint32_t *respVals,
+                                const uint32_t *shadowVals, size_t count,
+                                uint64_t *chgdBits, size_t u)
+{
+  if (u < count)  {
+    uint64_t lastWord = chgdBits[u / 64];
+    LCPUtil::findChangedRegsScalar(respVals + u, shadowVals + u, count - u,
+                                   chgdBits + u / 64);
+    chgdBits[u / 64] = lastWord | (chgdBits[u / 64] << (u % 64));
+  }
+
+  size_t numChgd = 0;
+  for (size_t w=0; w<(count + 63) / 64; ++w)
+    numChgd += __builtin_popcountll(chgdBits[w]);
+
+  return numChgd;
+}
+
+//-----------------------------------------------------------------------------
+//  Compare 8 registers at a time.  Each compare gives a mask with one bit per
+//  register (set if equal), which is inverted and stored in the bitmap.  The
+//  vector width divides 64, so each mask fits in one bitmap word.
+//-----------------------------------------------------------------------------
+__attribute__((target("avx2")))
+size_t LCPUtil::findChangedRegsAVX2(const uint32_t *respVals,
+                                    const uint32_t *shadowVals, size_t count,
+                                    uint64_t *chgdBits)
+{
+  const size_t VecRegs = 8;
+  const uint64_t AllRegs = (uint64_t(1) << VecRegs) - 1;
+  size_t u = 0;
+
+  for (size_t w=0; w<(count + 63) / 64; ++w)  chgdBits[w] = 0;
+
+  for (; u + VecRegs <= count; u += VecRegs)  {
+    __m256i newVals = _mm256_loadu_si256((const __m256i *)(respVals + u));
+    __m256i oldVals = _mm256_loadu_si256((const __m256i *)(shadowVals + u));
+    uint64_t sameMask = _mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpeq_epi32(newVals, oldVals)));
+    chgdBits[u / 64] |= (~sameMask & AllRegs) << (u % 64);
+  }
+
+  return finishChangedRegs(respVals, shadowVals, count, chgdBits, u);
+}
+
+//-----------------------------------------------------------------------------
+//  Same as findChangedRegsAVX2(), 4 registers at a time
+//-----------------------------------------------------------------------------
+__attribute__((target("sse2")))
+size_t LCPUtil::findChangedRegsSSE2(const uint32_t *respVals,
+                                    const uint32_t *shadowVals, size_t count,
+                                    uint64_t *chgdBits)
+{
+  const size_t VecRegs = 4;
+  const uint64_t AllRegs = (uint64_t(1) << VecRegs) - 1;
+  size_t u = 0;
+
+  for (size_t w=0; w<(count + 63) / 64; ++w)  chgdBits[w] = 0;
+
+  for (; u + VecRegs <= count; u += VecRegs)  {
+    __m128i newVals = _mm_loadu_si128((const __m128i *)(respVals + u));
+    __m128i oldVals = _mm_loadu_si128((const __m128i *)(shadowVals + u));
+    uint64_t sameMask = _mm_movemask_ps(
+        _mm_castsi128_ps(_mm_cmpeq_epi32(newVals, oldVals)));
+    chgdBits[u / 64] |= (~sameMask & AllRegs) << (u % 64);
+  }
+
+  return finishChangedRegs(respVals, shadowVals, count, chgdBits, u);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//  Byte-at-a-time CRC-32C (reflected polynomial 0x82F63B78)
+//-----------------------------------------------------------------------------
+uint32_t LCPUtil::crc32cScalar(const uint8_t *data, size_t count, uint32_t crc)
+{
+  static const array<uint32_t, 256> table = [] {
+    array<uint32_t, 256> tbl {};
+    for (uint32_t n=0; n<256; ++n)  {
+      uint32_t c = n;
+      for (int k=0; k<8; ++k)  c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : c >> 1;
+      tbl[n] = c;
+    }
+    return tbl;
+  }();
+
+  crc = ~crc;
+  for (size_t u=0; u<count; ++u)  crc = table[(crc ^ data[u]) & 0xFF] ^ (crc >> 8);
+
+  return ~crc;
+}
+
+//-----------------------------------------------------------------------------
+//  Pick the version of crc32c() for the CPU we are running on (once), the
+//  same way as findChangedRegs()
+//-----------------------------------------------------------------------------
+uint32_t LCPUtil::crc32c(const uint8_t *data, size_t count, uint32_t crc)
+{
+  using CrcFn = uint32_t (*)(const uint8_t *, size_t, uint32_t);
+
+  static const CrcFn crcFn = [] () -> CrcFn {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2"))  return crc32cSSE42;
+#endif
+    return crc32cScalar;
+  }();
+
+  return crcFn(data, count, crc);
+}
+
+#if defined(__x86_64__)
+//-----------------------------------------------------------------------------
+//  8 bytes per CRC32 instruction, then the bytes left over one at a time
+//-----------------------------------------------------------------------------
+__attribute__((target("sse4.2")))
+uint32_t LCPUtil::crc32cSSE42(const uint8_t *data, size_t count, uint32_t crc)
+{
+  uint64_t c = ~crc;
+  size_t u = 0;
+
+  for (; u + 8 <= count; u += 8)  {
+    uint64_t word;
+    memcpy(&word, data + u, sizeof(word));
+    c = _mm_crc32_u64(c, word);
+  }
+  for (; u < count; ++u)  c = _mm_crc32_u8(uint32_t(c), data[u]);
+
+  return ~uint32_t(c);
+}
+#endif
+
 //-----------------------------------------------------------------------------
 LCPCmdBase::LCPCmdBase(const int cmdHdrWords, const int respHdrWords,const int cmdBufSize, const int respBufSize):
     CmdHdrWords(cmdHdrWords),
     RespHdrWords(respHdrWords),
     cmdBuf(cmdBufSize,0),
-    respBuf(respBufSize,0)
+    respBuf(respBufSize,0),
+    respLen(0)
 {
 }
 
@@ -109,6 +293,15 @@ LCPWriteBlock::LCPWriteBlock(const uint chipNum, const uint32_t blockSize, const
   setBlockNum(blockNum);
 }
 
+LCPChecksumBlock::LCPChecksumBlock(const uint chipNum, const uint32_t blockSize, const uint32_t blockNum):
+    LCPCmdPmemBase(5,6,5,7)
+{
+  setPmemCmd(LCPCommand::CHECKSUM_BLOCK);
+  setChipNum(chipNum);
+  setBlockSize(blockSize);
+  setBlockNum(blockNum);
+}
+
 LCPReqWriteAccess::LCPReqWriteAccess(const uint16_t drvsessionID):
     LCPCmdBase(2,2,3,5)
 {
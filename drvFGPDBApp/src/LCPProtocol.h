@@ -21,7 +21,8 @@ enum class LCPCommand : std::int32_t {
   ERASE_BLOCK      = 4,    //!< Ease memory block
   READ_BLOCK       = 5,    //!< Read memory block
   WRITE_BLOCK      = 6,    //!< Write memory block
-  REQ_WRITE_ACCESS = 7     //!< Request write access
+  REQ_WRITE_ACCESS = 7,    //!< Request write access
+  CHECKSUM_BLOCK   = 8     //!< CRC-32C of memory block
 };
 
 /**
@@ -116,6 +117,72 @@ public:
    */
   static int generateSessionId();
 
+  /**
+   * @brief Method that compares the register values in a READ_REGS response
+   *        with a shadow copy of the previous ones (both in network byte
+   *        order) and sets a bit for each one that changed.  Uses AVX2 or
+   *        SSE2 instructions when the CPU it runs on supports them.
+   *
+   * @param[in]  respVals   register values from the response
+   * @param[in]  shadowVals previous values of the same registers
+   * @param[in]  count      # of registers
+   * @param[out] chgdBits   bit (u % 64) of word (u / 64) is set if register u
+   *                        changed (room for (count + 63) / 64 words)
+   *
+   * @return # of registers that changed
+   */
+  static size_t findChangedRegs(const uint32_t *respVals,
+                                const uint32_t *shadowVals, size_t count,
+                                uint64_t *chgdBits);
+
+  /**
+   * @brief Portable version of findChangedRegs() (also used for the
+   *        registers left over after the vector loop)
+   */
+  static size_t findChangedRegsScalar(const uint32_t *respVals,
+                                      const uint32_t *shadowVals, size_t count,
+                                      uint64_t *chgdBits);
+
+  /**
+   * @brief Method that calculates the CRC-32C (Castagnoli) of a buffer, the
+   *        same checksum the ctlr returns for CHECKSUM_BLOCK.  Uses the
+   *        SSE4.2 CRC32 instruction when the CPU it runs on supports it.
+   *
+   * @param[in] data  first byte
+   * @param[in] count # of bytes
+   * @param[in] crc   CRC of the previous bytes (to continue a calculation)
+   *
+   * @return CRC of the bytes
+   */
+  static uint32_t crc32c(const uint8_t *data, size_t count, uint32_t crc = 0);
+
+  /**
+   * @brief Portable (table-driven) version of crc32c()
+   */
+  static uint32_t crc32cScalar(const uint8_t *data, size_t count,
+                               uint32_t crc = 0);
+
+#if defined(__x86_64__)
+  /**
+   * @brief Version of crc32c() for CPUs with SSE4.2 (only called if the CPU
+   *        supports it)
+   */
+  static uint32_t crc32cSSE42(const uint8_t *data, size_t count, uint32_t crc);
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+  /**
+   * @brief Versions of findChangedRegs() for CPUs with AVX2 or SSE2 (only
+   *        called if the CPU supports them)
+   */
+  static size_t findChangedRegsAVX2(const uint32_t *respVals,
+                                    const uint32_t *shadowVals, size_t count,
+                                    uint64_t *chgdBits);
+  static size_t findChangedRegsSSE2(const uint32_t *respVals,
+                                    const uint32_t *shadowVals, size_t count,
+                                    uint64_t *chgdBits);
+#endif
+
 #ifndef TEST_DRVFGPDB
   private:
 #endif
@@ -316,12 +383,44 @@ public:
    */
   size_t getRespBuffSize(){ return (sizeof(respBuf.at(0))*respBuf.size());}
 
+  /**
+   * @brief Method to mark the response buffer as not (yet) holding the
+   *        response to the current request (see respRcvd())
+   */
+  void invalidateResp(){ setRespPktID(~getCmdPktID());  respLen = 0; }
+
+  /**
+   * @brief Method that returns the # of bytes in the response datagram
+   *        received (more bytes than the response buffer holds are dropped,
+   *        fewer leave the rest of the buffer unchanged)
+   *
+   * @return # of bytes (0 if no response was received yet)
+   */
+  size_t getRespLen(){ return respLen; }
+
+  /**
+   * @brief Method to set the # of bytes in the response datagram received
+   *
+   * @param[in] len # of bytes
+   */
+  void setRespLen(size_t len){ respLen = len; }
+
+  /**
+   * @brief Method to check if the response buffer holds the response to the
+   *        current request (i.e. the PktID and LCP Command match)
+   *
+   * @return true/false
+   */
+  bool respRcvd(){ return (getRespPktID() == getCmdPktID()) and
+                          (getRespLCPCommand() == getCmdLCPCommand()); }
+
 private:
   const int CmdHdrWords;    //!< Number of uint32_t words in the request buffer
   const int RespHdrWords;   //!< Number of uint32_t words in the response buffer
 
   std::vector<uint32_t> cmdBuf;   //!< Request Buffer
   std::vector<uint32_t> respBuf;  //!< Response Buffer
+  size_t respLen;                 //!< # of bytes in the response received (0 = none)
 };
 
 
@@ -347,7 +446,7 @@ public:
   /**
    * @brief Method to set the PMEM-relate LCP-Cmd in the request buffer
    *
-   * @param[in] command  ERASE_BLOCK, READ_BLOCK or WRITE_BLOCK
+   * @param[in] command  ERASE_BLOCK, READ_BLOCK, WRITE_BLOCK or CHECKSUM_BLOCK
    */
   void setPmemCmd(const LCPCommand command);
 
@@ -372,6 +471,13 @@ public:
    */
   void setBlockNum(const uint32_t blockNum);
 
+  /**
+   * @brief Method that returns the Block Size of the request buffer
+   *
+   * @return size of the block
+   */
+  uint32_t getBlockSize(){ return getCmdBufData(3); }
+
 };
 
 /**
@@ -392,6 +498,20 @@ public:
    *
    */
   LCPReadRegs(const uint Offset, const uint Count, const uint32_t Interval);
+
+  /**
+   * @brief Method that returns the address of the first register to read
+   *
+   * @return register address
+   */
+  uint32_t getOffset(){ return getCmdBufData(2); }
+
+  /**
+   * @brief Method that returns the number of registers to read
+   *
+   * @return number of registers
+   */
+  uint32_t getCount(){ return getCmdBufData(3); }
 };
 
 /**
@@ -408,6 +528,20 @@ public:
    *
    */
   LCPWriteRegs(const uint Offset, const uint Count);
+
+  /**
+   * @brief Method that returns the address of the first register to write
+   *
+   * @return register address
+   */
+  uint32_t getOffset(){ return getCmdBufData(2); }
+
+  /**
+   * @brief Method that returns the number of registers to write
+   *
+   * @return number of registers
+   */
+  uint32_t getCount(){ return getCmdBufData(3); }
 };
 
 /**
@@ -428,6 +562,38 @@ public:
    *
    */
   LCPReadWF(const uint32_t waveformID, const uint32_t Offset,const uint32_t Count, const uint32_t Interval);
+
+  /**
+   * @brief Method that returns the ID of the waveform to read
+   *
+   * @return waveform ID
+   */
+  uint32_t getWaveformID(){ return getCmdBufData(2); }
+
+  /**
+   * @brief Method that returns the offset of the first value to read
+   *
+   * @return offset in the waveform
+   */
+  uint32_t getOffset(){ return getCmdBufData(3); }
+
+  /**
+   * @brief Method that returns the number of values to read
+   *
+   * @return number of values
+   */
+  uint32_t getCount(){ return getCmdBufData(4); }
+
+  /**
+   * @brief Method that sets the part of a waveform to read.  The count must
+   *        not be larger than the one used to construct the cmd.
+   *
+   * @param[in] waveformID  ID of waveform to be read
+   * @param[in] Offset      The offset of the first value to return
+   * @param[in] Count       The number of values to return
+   */
+  void setRange(const uint32_t waveformID, const uint32_t Offset, const uint32_t Count){
+    setCmdBufData(2, waveformID);  setCmdBufData(3, Offset);  setCmdBufData(4, Count); }
 };
 
 /**
@@ -484,6 +650,32 @@ public:
   LCPWriteBlock(const uint chipNum, const uint32_t blockSize, const uint32_t blockNum);
 };
 
+/**
+ * @brief Checksum PMEM Block LCP-Cmd class
+ */
+class LCPChecksumBlock : public LCPCmdPmemBase {
+public:
+  /**
+   * C-tor of Checksum PMEM Block LCP-Cmd.
+   *
+   * @param[in] chipNum    value indicating which memory chip to access
+   *
+   * @param[in] blockSize  size of the block to checksum
+   *
+   * @param[in] blockNum   block number to checksum
+   *
+   */
+  LCPChecksumBlock(const uint chipNum, const uint32_t blockSize, const uint32_t blockNum);
+
+  /**
+   * @brief Method that returns the CRC-32C of the block's bytes (see
+   *        LCPUtil::crc32c())
+   *
+   * @return checksum in host format
+   */
+  uint32_t getRespChecksum(){ return getRespBufData(getRespHdrWords()); }
+};
+
 /**
  * @brief Require Write Access LCP-Cmd class
  */
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 
 #include <asynPortDriver.h>
 
@@ -13,7 +16,10 @@ const std::map<std::string, asynParamType> ParamInfo::asynTypes = {
   { "UInt32Digital", asynParamUInt32Digital },
   { "Float64",       asynParamFloat64       },
   { "Octet",         asynParamOctet         },
-  { "Int8Array",     asynParamInt8Array     }
+  { "Int8Array",     asynParamInt8Array     },
+  { "Int32Array",    asynParamInt32Array    },
+  { "Float32Array",  asynParamFloat32Array  },
+  { "Float64Array",  asynParamFloat64Array  }
 };
 
 //NotDefined: Init value of every param's ctlrFmt and value of all driver-only param's ctlrFmt
@@ -25,14 +31,23 @@ const std::map<std::string, CtlrDataFmt> ParamInfo::ctlrFmts = {
   { "U16_16",     CtlrDataFmt::U16_16    }
 };
 
+//Default: scan class of every param without a SCAN= option
+const std::map<std::string, ScanClass> ParamInfo::scanClasses = {
+  { "10Hz",  ScanClass::Hz10  },
+  { "1Hz",   ScanClass::Hz1   },
+  { "0.1Hz", ScanClass::Hz0_1 }
+};
+
 static string NotDefined("<NotDefined>");
 
 //-----------------------------------------------------------------------------
 // Construct a ParamInfo object from a string description of the form:
 //
-//  name addr asynType ctlrFmt
+//  name addr asynType ctlrFmt [ADEL=x] [RDEL=x] [MINT=ms] [SCAN=class]
 //    OR
 //  name addr chipID blockSize eraseReq offset len readStatusParam writeStatusParam
+//    OR
+//  name addr WF waveformID len asynType ctlrFmt
 //-----------------------------------------------------------------------------
 ParamInfo::ParamInfo(const string& paramStr)
          : regAddr(0),
@@ -48,13 +63,30 @@ ParamInfo::ParamInfo(const string& paramStr)
            dataOffset(0),
            bytesLeft(0),
            rwCount(0),
+           workBytes(0),
+           workBytesLeft(0),
+           readValUsed(false),
+           verifyLen(0),
+           waveformID(0),
+           wfLength(0),
+           absDeadband(0.0),
+           relDeadband(0.0),
+           minPostInterval(0),
+           scanClass(ScanClass::Default),
+           pendingList(nullptr),
+           listID(-1),
+           onPendingList(false),
            setState(SetState::Undefined),
            readState(ReadState::Undefined),
            ctlrValSet(0),
            ctlrValRead(0),
            drvValue(nullptr),
            rdStatusParamID(-1),
-           wrStatusParamID(-1)
+           wrStatusParamID(-1),
+           rdRateParamID(-1),
+           readRate(0),
+           subBlockSize(0),
+           streamBytes(0)
 {
   stringstream paramStream(paramStr);
 
@@ -66,6 +98,7 @@ ParamInfo::ParamInfo(const string& paramStr)
                 >> ctlrFmtName;
     asynType = strToAsynType(asynTypeName);
     ctlrFmt = strToCtlrFmt(ctlrFmtName);
+    readDefOptions(paramStream);
     m_readOnly = LCPUtil::readOnlyAddr(regAddr);
   } else if (regex_match(paramStr, pmemParamDefRegex())) {
     string eraseReqStr;
@@ -76,13 +109,27 @@ ParamInfo::ParamInfo(const string& paramStr)
                 >> eraseReqStr
                 >> hex >> offset >> length
                 >> rdStatusParamName
-                >> wrStatusParamName;
+                >> wrStatusParamName
+                >> rdRateParamName;  // optional
     eraseReq = (eraseReqStr.at(0) == 'Y');
     asynType = asynParamInt8Array;
     m_readOnly = LCPUtil::readOnlyAddr(regAddr);
     arrayValRead.assign(length, 0);
     initBlockRW(arrayValRead.size());
     readState = ReadState::Update;
+  } else if (regex_match(paramStr, waveformParamDefRegex())) {
+    string wfTag, asynTypeName, ctlrFmtName;
+    paramStream >> name
+                >> hex >> regAddr
+                >> wfTag
+                >> dec >> waveformID
+                >> wfLength
+                >> asynTypeName
+                >> ctlrFmtName;
+    asynType = strToAsynType(asynTypeName);
+    ctlrFmt = strToCtlrFmt(ctlrFmtName);
+    m_readOnly = true;
+    initWaveformBufs();
   } else {
     throw invalid_argument("Invalid parameter definition string \"" + paramStr + "\"");
   }
@@ -92,6 +139,11 @@ ParamInfo::ParamInfo(const string& paramStr)
 //-----------------------------------------------------------------------------
 void ParamInfo::initBlockRW(uint32_t ttlNumBytes)
 {
+  subBlockSize = 0;  unreadSubBlocks.clear();
+  chgdBlocks.clear();  workBytes = workBytesLeft = ttlNumBytes;
+  readValUsed = false;  verifyBlocks.clear();  verifyLen = 0;
+  writtenCRCs.clear();
+
   if (!ttlNumBytes or !blockSize)  return;
 
   rwOffset = 0;
@@ -101,6 +153,154 @@ void ParamInfo::initBlockRW(uint32_t ttlNumBytes)
   rwCount = blockSize - dataOffset;
 }
 
+//-----------------------------------------------------------------------------
+//  Compare the new array value with the last one read from the ctlr, one
+//  block at a time.  Only a complete read value is trusted (one that is not
+//  being updated).
+//-----------------------------------------------------------------------------
+void ParamInfo::findChgdBlocks(void)
+{
+  uint32_t numBytes = arrayValSet.size();
+  if (!numBytes or !blockSize)  return;
+
+  bool haveReadVal = (readState == ReadState::Current) and
+                     (arrayValRead.size() >= numBytes);
+
+  ulong firstBlock = offset / blockSize;
+  ulong lastBlock = (offset + numBytes - 1) / blockSize;
+
+  chgdBlocks.assign(lastBlock - firstBlock + 1, true);
+  workBytes = 0;  readValUsed = haveReadVal;
+
+  for (ulong block=firstBlock; block<=lastBlock; ++block)  {
+    ulong from = max(block * blockSize, offset) - offset;
+    ulong to = min((block + 1) * blockSize, offset + numBytes) - offset;
+
+    bool chgd = !haveReadVal or
+                memcmp(arrayValSet.data() + from, arrayValRead.data() + from,
+                       to - from);
+
+    chgdBlocks[block - firstBlock] = chgd;
+    if (chgd)  workBytes += to - from;
+  }
+
+  workBytesLeft = workBytes;
+}
+
+//-----------------------------------------------------------------------------
+//  The blocks a write did not change already matched the last value read
+//  (see findChgdBlocks()), so only the changed ones need to be read back.
+//  That is only true if all of the array was either compared or written.
+//-----------------------------------------------------------------------------
+bool ParamInfo::initVerify(void)
+{
+  vector<bool> writtenBlocks;
+  writtenBlocks.swap(chgdBlocks);
+  bool allKnown = restOfArrayKnown();
+
+  initBlockRW(arrayValRead.size());
+
+  if (writtenBlocks.empty() or !allKnown or !blockSize or arrayValRead.empty())
+    return false;
+
+  verifyLen = min(arrayValSet.size(), arrayValRead.size());
+
+  ulong firstBlock = offset / blockSize;
+  ulong numBlocks = (offset + arrayValRead.size() - 1) / blockSize - firstBlock + 1;
+
+  verifyBlocks.assign(numBlocks, false);
+
+  for (ulong idx=0; idx<min<ulong>(numBlocks, writtenBlocks.size()); ++idx)
+    verifyBlocks[idx] = writtenBlocks[idx];
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ParamInfo::verifiedBlocksMatch(void) const
+{
+  ulong firstBlock = offset / blockSize;
+
+  for (ulong idx=0; idx<verifyBlocks.size(); ++idx)  {
+    if (!verifyBlocks[idx])  continue;
+    ulong block = firstBlock + idx;
+    ulong from = max(block * blockSize, offset) - offset;
+    ulong to = min((block + 1) * blockSize, offset + verifyLen) - offset;
+    if (memcmp(arrayValRead.data() + from, arrayValSet.data() + from, to - from))
+      return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ParamInfo::acceptVerifiedWrite(void)
+{
+  if (!restOfArrayKnown())  return false;
+
+  memcpy(arrayValRead.data(), arrayValSet.data(),
+         min(arrayValSet.size(), arrayValRead.size()));
+
+  initBlockRW(arrayValRead.size());
+  bytesLeft = 0;  // nothing to read back
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ParamInfo::getCachedBlock(vector<uint8_t> &buf) const
+{
+  if (!blockSize or (buf.size() < blockSize))  return false;
+
+  ulong idx = blockNum - offset / blockSize;
+  if ((idx >= blockValid.size()) or !blockValid[idx])  return false;
+
+  ulong firstByte = offset, endByte = offset + arrayValRead.size();
+  ulong blockStart = ulong(blockNum) * blockSize, blockEnd = blockStart + blockSize;
+  ulong headStart = firstByte - headBytes.size();
+
+  for (ulong addr=blockStart; addr<blockEnd; )  {
+    ulong to;
+    const uint8_t *src;
+    if (addr < firstByte)  {
+      to = min(firstByte, blockEnd);  src = headBytes.data() + (addr - headStart); }
+    else if (addr < endByte)  {
+      to = min(endByte, blockEnd);  src = arrayValRead.data() + (addr - firstByte); }
+    else  {
+      to = blockEnd;  src = tailBytes.data() + (addr - endByte); }
+    memcpy(buf.data() + (addr - blockStart), src, to - addr);
+    addr = to;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void ParamInfo::invalidateBlock(void)
+{
+  ulong idx = blockNum - offset / blockSize;
+  if (idx < blockValid.size())  blockValid[idx] = false;
+}
+
+//-----------------------------------------------------------------------------
+bool ParamInfo::blockChgd(void) const
+{
+  ulong idx = blockNum - offset / blockSize;
+
+  return (idx >= chgdBlocks.size()) or chgdBlocks[idx];
+}
+
+//-----------------------------------------------------------------------------
+void ParamInfo::advanceBlock(void)
+{
+  if (rwCount > bytesLeft)  rwCount = bytesLeft;
+
+  if (blockChgd())  workBytesLeft -= min<uint32_t>(rwCount, workBytesLeft);
+
+  ++blockNum;  dataOffset = 0;  bytesLeft -= rwCount;
+  rwOffset += rwCount;  rwCount = blockSize;
+}
+
 
 //-----------------------------------------------------------------------------
 // Generate a regex for basic validation of strings that define a parameter for
@@ -116,9 +316,17 @@ const regex& ParamInfo::scalarParamDefRegex()
   const string asynType     = "(" + joinMapKeys(asynTypes, "|") + ")";
   const string ctlrFmt      = "(" + joinMapKeys(ctlrFmts,  "|") + ")";
 
+  const string number       = "[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?";
+  const string scanClass    = "(" + regex_replace(joinMapKeys(scanClasses, "|"),
+                                                regex("\\."), "\\.") + ")";
+  const string filterOption = "((ADEL|RDEL)=" + number + "|MINT=[0-9]+"
+                              "|SCAN=" + scanClass + ")";
+
   const string optionalPart = "(" + whiteSpaces + address
                                   + whiteSpaces + asynType
-                                  + "(" + whiteSpaces + ctlrFmt + ")?"
+                                  + "(" + whiteSpaces + ctlrFmt
+                                        + "(" + whiteSpaces + filterOption + ")*"
+                                  + ")?"
                             + ")?";
 
   static const regex re(paramName + optionalPart);
@@ -126,6 +334,34 @@ const regex& ParamInfo::scalarParamDefRegex()
   return re;
 }
 
+//-----------------------------------------------------------------------------
+// Read the optional filters for new readings and scan class of a scalar param:
+//
+//  ADEL=x      absolute deadband (engineering units)
+//  RDEL=x      relative deadband (fraction of the current reading)
+//  MINT=ms     min interval between new readings
+//  SCAN=class  how often the reg is read (10Hz, 1Hz or 0.1Hz)
+//-----------------------------------------------------------------------------
+void ParamInfo::readDefOptions(istream &paramStream)
+{
+  string option;
+
+  while (paramStream >> option)  {
+    size_t sep = option.find('=');
+    string key = option.substr(0, sep);
+    string val = option.substr(sep + 1);
+
+    try {
+      if (key == "ADEL")       absDeadband = stod(val);
+      else if (key == "RDEL")  relDeadband = stod(val);
+      else if (key == "MINT")  minPostInterval = stoul(val);
+      else if (key == "SCAN")  scanClass = scanClasses.at(val);
+    } catch (out_of_range &)  {
+      throw invalid_argument("Invalid parameter filter \"" + option + "\"");
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 // Generate a regex for basic validation of strings that define a parameter for
 // a PMEM (persistent memory) value.
@@ -148,6 +384,7 @@ const regex& ParamInfo::pmemParamDefRegex()
 
   const string rdStatusParamName = "\\w+";
   const string wrStatusParamName = "\\w+";
+  const string rdRateParamName   = "\\w+";
 
 
   const string pmemArrayRegExStr = paramName
@@ -158,13 +395,86 @@ const regex& ParamInfo::pmemParamDefRegex()
                                  + whiteSpaces + offset
                                  + whiteSpaces + length
                                  + whiteSpaces + rdStatusParamName
-                                 + whiteSpaces + wrStatusParamName;
+                                 + whiteSpaces + wrStatusParamName
+                                 + "(" + whiteSpaces + rdRateParamName + ")?";
 
   static const regex re(pmemArrayRegExStr);
 
   return re;
 }
 
+//-----------------------------------------------------------------------------
+// Generate a regex for basic validation of strings that define a parameter for
+// a waveform value read from the ctlr.
+//-----------------------------------------------------------------------------
+const regex& ParamInfo::waveformParamDefRegex()
+{
+  const string paramName    = "\\w+";
+
+  const string whiteSpaces  = "\\s+";
+
+  const string address      = "0x[0-9a-fA-F]+";
+
+  const string waveformID   = "[0-9]+";
+  const string length       = "[1-9][0-9]*";
+
+  const string asynType     = "(Int32Array|Float32Array|Float64Array)";
+  const string ctlrFmt      = "(" + joinMapKeys(ctlrFmts,  "|") + ")";
+
+
+  const string waveformRegExStr = paramName
+                                + whiteSpaces + address
+                                + whiteSpaces + "WF"
+                                + whiteSpaces + waveformID
+                                + whiteSpaces + length
+                                + whiteSpaces + asynType
+                                + whiteSpaces + ctlrFmt;
+
+  static const regex re(waveformRegExStr);
+
+  return re;
+}
+
+//-----------------------------------------------------------------------------
+void ParamInfo::initWaveformBufs()
+{
+  if (!isWaveformParam() or (wfValRead.size() == wfLength))  return;
+
+  wfValRead.assign(wfLength, 0);
+
+  switch (asynType)  {
+    case asynParamInt32Array:    wfInt32.assign(wfLength, 0);    break;
+    case asynParamFloat32Array:  wfFloat32.assign(wfLength, 0);  break;
+    case asynParamFloat64Array:  wfFloat64.assign(wfLength, 0);  break;
+    default:  break;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//  Convert the most recently read waveform to the array used to post it
+//-----------------------------------------------------------------------------
+void ParamInfo::convertWaveform()
+{
+  switch (asynType)  {
+    case asynParamInt32Array:
+      for (size_t u=0; u<wfInt32.size(); ++u)
+        wfInt32[u] = (ctlrFmt == CtlrDataFmt::S32 or ctlrFmt == CtlrDataFmt::U32) ?
+                     (epicsInt32)wfValRead[u] :
+                     (epicsInt32)ctlrFmtToDouble(wfValRead[u], ctlrFmt);
+      break;
+    case asynParamFloat32Array:
+      for (size_t u=0; u<wfFloat32.size(); ++u)
+        wfFloat32[u] = ctlrFmtToDouble(wfValRead[u], ctlrFmt);
+      break;
+    case asynParamFloat64Array:
+      for (size_t u=0; u<wfFloat64.size(); ++u)
+        wfFloat64[u] = ctlrFmtToDouble(wfValRead[u], ctlrFmt);
+      break;
+    default:
+      break;
+  }
+}
+
 //-----------------------------------------------------------------------------
 //  Return a string definition for a parameter
 //-----------------------------------------------------------------------------
@@ -182,10 +492,23 @@ ostream& operator<<(ostream& os, const ParamInfo &param)
        << " 0x" << param.length
        << dec
        << " " << param.rdStatusParamName
-       << " " << param.wrStatusParamName;
-  else
+       << " " << param.wrStatusParamName
+       << (param.rdRateParamName.empty() ? "" : " ") << param.rdRateParamName;
+  else if (param.wfLength)
+    os << " WF" << dec
+       << " " << param.waveformID
+       << " " << param.wfLength
+       << " " << ParamInfo::asynTypeToStr(param.asynType)
+       << " " << ParamInfo::ctlrFmtToStr(param.ctlrFmt);
+  else  {
     os << " " << ParamInfo::asynTypeToStr(param.asynType)
        << " " << ParamInfo::ctlrFmtToStr(param.ctlrFmt);
+    if (param.absDeadband > 0.0)  os << " ADEL=" << param.absDeadband;
+    if (param.relDeadband > 0.0)  os << " RDEL=" << param.relDeadband;
+    if (param.minPostInterval)  os << dec << " MINT=" << param.minPostInterval;
+    for (auto& x: ParamInfo::scanClasses)
+      if (x.second == param.scanClass)  os << " SCAN=" << x.first;
+  }
 
   return os;
 }
@@ -194,11 +517,51 @@ ostream& operator<<(ostream& os, const ParamInfo &param)
 void ParamInfo::newReadVal(uint32_t newVal)
 {
   ctlrValRead = newVal;
-  readState = ReadState::Pending;
+  setReadPending();
+
+  if (minPostInterval)  lastReadTime = chrono::steady_clock::now();
 
   if (drvValue)  *drvValue = newVal;
 }
 
+//-----------------------------------------------------------------------------
+//  A new value must change by more than both deadbands and be read at least
+//  minPostInterval ms after the current reading.  Until the current reading
+//  is posted, it can be replaced without an extra callback, so any new value
+//  passes.
+//-----------------------------------------------------------------------------
+bool ParamInfo::passesReadingFilter(uint32_t newVal,
+                                    chrono::steady_clock::time_point now) const
+{
+  if ((readState != ReadState::Current) or !hasReadingFilter())  return true;
+
+  if (minPostInterval
+    and (now - lastReadTime < chrono::milliseconds(minPostInterval)))
+    return false;
+
+  if ((absDeadband > 0.0) or (relDeadband > 0.0))  {
+    double curVal = ctlrFmtToDouble(ctlrValRead, ctlrFmt);
+    double change = fabs(ctlrFmtToDouble(newVal, ctlrFmt) - curVal);
+
+    // NaN changes are never filtered out
+    if (change <= absDeadband)  return false;
+    if (change <= relDeadband * fabs(curVal))  return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void ParamInfo::setReadPending()
+{
+  readState = ReadState::Pending;
+
+  if (!pendingList or onPendingList)  return;
+
+  pendingList->push_back(listID);
+  onPendingList = true;
+}
+
 //-----------------------------------------------------------------------------
 int ParamInfo::getStatusParamID(void)
 {
@@ -219,6 +582,22 @@ uint32_t ParamInfo::getArraySize(void)
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+uint32_t ParamInfo::getWorkSize(void)
+{
+  if (activePMEMwrite())  return workBytes;
+
+  return getArraySize();
+}
+
+//-----------------------------------------------------------------------------
+uint32_t ParamInfo::getWorkLeft(void)
+{
+  if (activePMEMwrite())  return workBytesLeft;
+
+  return bytesLeft;
+}
+
 //-----------------------------------------------------------------------------
 asynParamType ParamInfo::strToAsynType(const string &typeName)
 {
@@ -301,7 +680,36 @@ paramDefState ParamInfo::updateParamDef(const string &context,
                                         CtlrDataFmt::NotDefined, paramDef);
   conflict |= (stat != asynSuccess);
 
-  m_readOnly = LCPUtil::readOnlyAddr(regAddr);
+  std::tie(stat, paramDef) = updateProp(absDeadband, newParam.absDeadband,
+                                        0.0, paramDef);
+  conflict |= (stat != asynSuccess);
+
+  std::tie(stat, paramDef) = updateProp(relDeadband, newParam.relDeadband,
+                                        0.0, paramDef);
+  conflict |= (stat != asynSuccess);
+
+  std::tie(stat, paramDef) = updateProp(scanClass, newParam.scanClass,
+                                        ScanClass::Default, paramDef);
+  conflict |= (stat != asynSuccess);
+
+  std::tie(stat, paramDef) = updateProp(minPostInterval,
+                                        newParam.minPostInterval,
+                                        static_cast<uint32_t>(0), paramDef);
+  conflict |= (stat != asynSuccess);
+
+  bool firstWaveformDef = (!wfLength and newParam.wfLength);
+
+  std::tie(stat, paramDef) = updateProp(wfLength, newParam.wfLength,
+                                        static_cast<uint32_t>(0), paramDef);
+  conflict |= (stat != asynSuccess);
+
+  // waveformID 0 is valid, so it is only taken from a def that has a length
+  if (firstWaveformDef)  waveformID = newParam.waveformID;
+  else if (newParam.wfLength)  conflict |= (waveformID != newParam.waveformID);
+
+  m_readOnly = wfLength ? true : LCPUtil::readOnlyAddr(regAddr);
+
+  if (!conflict)  initWaveformBufs();
 
   if (conflict) {
     ostringstream oss;
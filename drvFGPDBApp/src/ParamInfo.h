@@ -7,6 +7,7 @@
  */
 
 #include <regex>
+#include <chrono>
 #include <map>
 #include <iostream>
 
@@ -48,6 +49,17 @@ enum class ReadState {
   Current     //!< most recent value posted to asyn layer
 };
 
+/**
+ * @brief How often the driver reads the value of an LCP reg
+ * @note  Be sure to update ParamInfo::scanClasses in ParamInfo.cpp
+ */
+enum class ScanClass {
+  Default,  //!< read at the driver's default rate (every 200 ms)
+  Hz10,     //!< read every 100 ms
+  Hz1,      //!< read every second
+  Hz0_1     //!< read every 10 seconds
+};
+
 /**
  * @brief Class to describe if a param has been updated with a new definition string
  */
@@ -83,13 +95,49 @@ class ParamInfo {
     uint32_t       dataOffset;  //!< Offset in to r/w cmd's block buffer
     uint32_t       bytesLeft;   //!< Number of bytes left to r/w
     uint           rwCount;     //!< Number of bytes req in PMEM r/w cmd
+
+    std::vector<bool>  chgdBlocks;  //!< blocks (from the 1st one of the array) changed by arrayValSet
+    uint32_t       workBytes;     //!< # of bytes in the changed blocks
+    uint32_t       workBytesLeft; //!< # of bytes in the changed blocks not written yet
+    bool           readValUsed;   //!< findChgdBlocks() compared arrayValSet with a complete read value
+
+    // state data for verifying a write by reading back only the blocks it
+    // changed (see initVerify())
+    std::vector<bool>  verifyBlocks;  //!< blocks (from the 1st one of the array) to read back (empty == all)
+    uint32_t       verifyLen;     //!< # of bytes of arrayValSet compared with the bytes read back
+
+    /**
+     * @brief Method to know if the blocks of the array a write did not
+     *        change are known to match the ctlr (see findChgdBlocks())
+     */
+    bool restOfArrayKnown(void) const {
+      return readValUsed or (arrayValSet.size() >= arrayValRead.size()); }
+
+    // properties for waveform parameters
+    uint32_t       waveformID;  //!< ID of the waveform in the ctlr
+    uint32_t       wfLength;    //!< Number of values in the waveform
+
+    // filters applied to new readings of scalar params (0 if not used)
+    double         absDeadband;   //!< min change (in engineering units) of a new reading
+    double         relDeadband;   //!< min change of a new reading, as a fraction of the current one
+    uint32_t       minPostInterval; //!< min # of ms between new readings
+
+    std::chrono::steady_clock::time_point  lastReadTime;  //!< time of the last new reading (only kept if minPostInterval)
+
+    ScanClass      scanClass;   //!< how often the LCP reg is read
+
+    // list of params with new readings to be posted
+    std::vector<int> *pendingList;  //!< Driver's list of params with readState Pending
+    int            listID;      //!< ID added to pendingList for this param
+    bool           onPendingList; //!< listID is already in pendingList
   public:
     /**
      * @brief Constructs the Parameter object.
      *
      * @param[in] paramStr string that describes the parameter. Formats allowed are:
-     *                     - name addr asynType ctlrFmt.
+     *                     - name addr asynType ctlrFmt [ADEL=x] [RDEL=x] [MINT=ms] [SCAN=class].
      *                     - name addr chipID blockSize eraseReq offset length statusName.
+     *                     - name addr WF waveformID length asynType ctlrFmt.
      */
     ParamInfo(const std::string& paramStr);
 
@@ -100,6 +148,75 @@ class ParamInfo {
      */
     void initBlockRW(uint32_t ttlNumBytes);
 
+    /**
+     * @brief Method that compares arrayValSet with the last value read from
+     *        the ctlr to find the blocks a write has to change.  If there is
+     *        no complete read value, all the blocks are changed.  Call after
+     *        initBlockRW().
+     */
+    void findChgdBlocks(void);
+
+    /**
+     * @brief Method to know if the current block of a write is changed by
+     *        arrayValSet (see findChgdBlocks())
+     *
+     * @return true/false
+     */
+    bool blockChgd(void) const;
+
+    /**
+     * @brief Method that moves the array read/write process on to the next
+     *        block (after the current one is done or skipped).
+     */
+    void advanceBlock(void);
+
+    /**
+     * @brief Method that gets a param ready to verify the write that just
+     *        finished by reading back only the blocks it changed and
+     *        comparing them with the bytes written.
+     *        Used instead of initBlockRW() for the readback.
+     *
+     * @return false if the rest of the array is not known to match the
+     *         ctlr (i.e. all of it has to be read back)
+     */
+    bool initVerify(void);
+
+    /**
+     * @brief Method to know if a block is read by the current read
+     *
+     * @param[in] idx # of the block (from the 1st one of the array)
+     *
+     * @return true/false
+     */
+    bool verifyBlock(size_t idx) const {
+      return verifyBlocks.empty() or ((idx < verifyBlocks.size()) and verifyBlocks[idx]);
+    }
+
+    /**
+     * @brief Method to know if the current read only verifies a write
+     */
+    bool verifyingWrite(void) const { return !verifyBlocks.empty(); }
+
+    /**
+     * @brief Method that compares the bytes read back from each verified
+     *        block with the bytes written to it
+     *
+     * @return true if all of them match
+     */
+    bool verifiedBlocksMatch(void) const;
+
+    /**
+     * @brief Method that makes the value just written the new read value,
+     *        once the ctlr's CRC of each block written matched the CRC of
+     *        the bytes sent (see drvFGPDB::verifyArrayWrite())
+     *
+     * @return false if the rest of the array is not known to match the
+     *         ctlr (i.e. all of it has to be read back)
+     */
+    bool acceptVerifiedWrite(void);
+
+    std::vector<std::pair<uint32_t, uint32_t>> writtenCRCs;  //!< block # and CRC-32C of each block written by the current write
+
     /**
      * @brief Updates the properties for an existing parameter.
      *        Checks for conflicts and updates any missing property values using ones
@@ -214,8 +331,68 @@ class ParamInfo {
                 (asynType == asynParamFloat64Array)) );
     }
 
+    /**
+     * @brief Method to know if the parameter is a ctlr waveform
+     *
+     * @return true/false
+     */
+    bool isWaveformParam() const {
+      return (wfLength and
+               ((asynType == asynParamInt32Array) or
+                (asynType == asynParamFloat32Array) or
+                (asynType == asynParamFloat64Array)) );
+    }
+
     void newReadVal(uint32_t newVal);
 
+    /**
+     * @brief Method to know if the param has any filter for new readings
+     *
+     * @return true/false
+     */
+    bool hasReadingFilter() const {
+      return (absDeadband > 0.0) or (relDeadband > 0.0) or minPostInterval; }
+
+    /**
+     * @brief Method that applies the deadbands and min interval of the param
+     *        to a value just read from the ctlr.  Values read before the
+     *        current one is posted always pass.
+     *
+     * @param[in] newVal  value read (ctlr fmt, host byte order)
+     * @param[in] now     time the value was read
+     *
+     * @return true if the value should become the param's new reading
+     */
+    bool passesReadingFilter(uint32_t newVal,
+                             std::chrono::steady_clock::time_point now) const;
+
+    ScanClass getScanClass() const { return scanClass; }
+
+    double   getAbsDeadband()     const { return absDeadband;     }
+    double   getRelDeadband()     const { return relDeadband;     }
+    uint32_t getMinPostInterval() const { return minPostInterval; }
+
+    /**
+     * @brief Method to set the list that the param's ID is added to each time
+     *        it has a new reading to be posted
+     *
+     * @param[in] list     driver's list of params with pending readings
+     * @param[in] paramID  ID to add to the list
+     */
+    void setPendingList(std::vector<int> *list, int paramID) {
+      pendingList = list;  listID = paramID; }
+
+    /**
+     * @brief Method to flag a new reading as ready to be posted.  Adds the
+     *        param to the pending list (if not already on it).
+     */
+    void setReadPending();
+
+    /**
+     * @brief Method called when the param is taken off the pending list
+     */
+    void clearOnPendingList() { onPendingList = false; }
+
 
     std::string    name;        //!< Name of the parameter
 
@@ -246,6 +423,7 @@ class ParamInfo {
     uint  getChipNum()   const { return chipNum;   }
     ulong getBlockSize() const { return blockSize; }
     bool  getEraseReq()  const { return eraseReq;  }
+    ulong getOffset()    const { return offset;    }
 
     std::string    rdStatusParamName; //!< Name of param for status of a PMEM read oper
     int            rdStatusParamID;   //!< ID of the rdStatusParam
@@ -253,6 +431,10 @@ class ParamInfo {
     std::string    wrStatusParamName; //!< Name of param for status of a PMEM write oper
     int            wrStatusParamID;   //!< ID of the wrStatusParam
 
+    std::string    rdRateParamName;   //!< Name of (optional) param for the rate of a PMEM read oper (kB/s)
+    int            rdRateParamID;     //!< ID of the rdRateParam (-1 if none)
+    uint32_t       readRate;          //!< effective rate of the current/last read of the array (kB/s)
+
     // state data for in-progress read or write of an array value
     uint32_t getRWOffset() const { return rwOffset; }
     void setRWOffset(uint32_t newRWOffset) { rwOffset = newRWOffset; }
@@ -282,8 +464,58 @@ class ParamInfo {
 
     uint32_t getArraySize(void);  //!< size of array for active active PMEM read or write
 
+    uint32_t getWorkSize(void);   //!< # of bytes to transfer for the active PMEM read or write
+    uint32_t getWorkLeft(void);   //!< # of those bytes not transferred yet
+
     std::vector<uint8_t> rwBuf;
 
+    // state data for a streaming read of an array value (see
+    // drvFGPDB::readNextBlock())
+    uint32_t  subBlockSize;                 //!< # of bytes read by each READ_BLOCK cmd (0 until the read starts)
+    uint32_t  streamBytes;                  //!< # of array bytes requested by the read (the blocks it skips don't count)
+    std::vector<uint32_t> unreadSubBlocks;  //!< #s of the sub-blocks not read yet (the last one is read first)
+    std::chrono::steady_clock::time_point  readStartTime;  //!< when the read started
+
+    // cache of the ctlr's copy of the blocks that hold the array value (the
+    // bytes in the array are in arrayValRead, the rest of the 1st and last
+    // blocks are in headBytes and tailBytes)
+    std::vector<bool>     blockValid;     //!< blocks (from the 1st one of the array) whose cached bytes match the ctlr
+    std::vector<uint32_t> blockSubsLeft;  //!< # of sub-blocks of each block not read yet by the current read
+    std::vector<uint8_t>  headBytes;      //!< bytes of the 1st block before the start of the array
+    std::vector<uint8_t>  tailBytes;      //!< bytes of the last block after the end of the array
+
+    /**
+     * @brief Method that copies the cached bytes of the current block of a
+     *        read/write in to a buffer
+     *
+     * @param[out] buf buffer for the blockSize # of bytes
+     *
+     * @return false if the cached bytes are not known to be current
+     */
+    bool getCachedBlock(std::vector<uint8_t> &buf) const;
+
+    /**
+     * @brief Method that flags the cached bytes of the current block of a
+     *        read/write as no longer current
+     */
+    void invalidateBlock(void);
+
+
+    // properties for waveform parameters
+    uint32_t getWaveformID()     const { return waveformID; }
+    uint32_t getWaveformLength() const { return wfLength;   }
+
+    std::vector<uint32_t>     wfValRead;  //!< Most recently read waveform @note In ctlr fmt, host byte order!
+    std::vector<epicsInt32>   wfInt32;    //!< wfValRead converted for an Int32Array param
+    std::vector<epicsFloat32> wfFloat32;  //!< wfValRead converted for a Float32Array param
+    std::vector<epicsFloat64> wfFloat64;  //!< wfValRead converted for a Float64Array param
+
+    /**
+     * @brief Method to convert wfValRead to the array used to post the waveform
+     *        to the asyn layer (the one that matches the asynType)
+     */
+    void convertWaveform();
+
 #ifndef TEST_DRVFGPDB
   private:
 #endif
@@ -303,8 +535,30 @@ class ParamInfo {
      */
     static const std::regex& pmemParamDefRegex();
 
+    /**
+     * @brief Generates a regex for basic validation of strings that define a parameter for
+     *        a waveform value.
+     *
+     * @return waveform regex
+     */
+    static const std::regex& waveformParamDefRegex();
+
+    /**
+     * @brief Allocates the buffers for a waveform param (once its length is known)
+     */
+    void initWaveformBufs();
+
+    /**
+     * @brief Sets the filters for new readings and the scan class from the
+     *        optional "key=value" fields at the end of a scalar param definition
+     *
+     * @param[in] paramStream stream positioned after the ctlrFmt
+     */
+    void readDefOptions(std::istream &paramStream);
+
     static const std::map<std::string, asynParamType> asynTypes;  //!< Map w/ the asyn data formats supported by the driver
     static const std::map<std::string, CtlrDataFmt> ctlrFmts;     //!< Map w/ the data formats supported by the ctlr
+    static const std::map<std::string, ScanClass> scanClasses;    //!< Map w/ the names of the scan classes
 };
 
 /**
@@ -0,0 +1,197 @@
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <algorithm>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "PmemCache.h"
+
+using namespace std;
+
+const uint32_t PmemCache::Version;
+
+static const char CacheMagic[8] = { 'F','G','P','D','B','P','M','C' };
+
+//-----------------------------------------------------------------------------
+PmemCache::PmemCache(const string &ctlrID_, uint32_t chipNum_,
+                     uint32_t offset_, uint32_t length_, uint32_t blockSize_) :
+    ctlrID(ctlrID_.substr(0, sizeof(Header::ctlrID) - 1)),
+    chipNum(chipNum_),
+    offset(offset_),
+    length(length_),
+    blockSize(blockSize_),
+    numBlocks(0),
+    mapAddr(nullptr),
+    mapSize(0),
+    header(nullptr),
+    hashes(nullptr),
+    image(nullptr)
+{
+  if (length and blockSize)
+    numBlocks = (uint64_t(offset) + length - 1) / blockSize
+              - offset / blockSize + 1;
+}
+
+//-----------------------------------------------------------------------------
+PmemCache::~PmemCache()
+{
+  if (mapAddr)  {
+    msync(mapAddr, mapSize, MS_SYNC);
+    munmap(mapAddr, mapSize);
+  }
+}
+
+//-----------------------------------------------------------------------------
+//  The file name has the whole key, so each region of each ctlr gets its own
+//  file.  A file that was created for a different key (or an older layout)
+//  is resized and reinitialized.
+//-----------------------------------------------------------------------------
+asynStatus PmemCache::open(const string &dir)
+{
+  if (isOpen())  return asynSuccess;
+  if (!numBlocks or dir.empty())  return asynError;
+
+  string name = ctlrID;
+  replace_if(name.begin(), name.end(),
+             [](char c) { return !isalnum(static_cast<unsigned char>(c)); },
+             '_');
+  char keyStr[64];
+  snprintf(keyStr, sizeof(keyStr), "_c%u_o%08x_l%u_b%u.pmem",
+           chipNum, offset, length, blockSize);
+  path = dir + "/" + name + keyStr;
+
+  size_t fileSize = sizeof(Header) + numBlocks * sizeof(uint64_t) + length;
+
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0)  return asynError;
+
+  struct stat st;
+  if (fstat(fd, &st) or
+      ((size_t(st.st_size) != fileSize) and ftruncate(fd, fileSize)))  {
+    close(fd);  return asynError; }
+
+  void *addr = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+  close(fd);  // the mapping keeps the file open
+  if (addr == MAP_FAILED)  return asynError;
+
+  mapAddr = addr;  mapSize = fileSize;
+  header = static_cast<Header *>(addr);
+  hashes = reinterpret_cast<uint64_t *>(header + 1);
+  image = reinterpret_cast<uint8_t *>(hashes + numBlocks);
+
+  if (!keyMatches())  initHeader();
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+bool PmemCache::keyMatches() const
+{
+  return !memcmp(header->magic, CacheMagic, sizeof(CacheMagic))
+     and (header->version == Version)
+     and (header->chipNum == chipNum)
+     and (header->offset == offset)
+     and (header->length == length)
+     and (header->blockSize == blockSize)
+     and (header->numBlocks == numBlocks)
+     and !strncmp(header->ctlrID, ctlrID.c_str(), sizeof(header->ctlrID));
+}
+
+//-----------------------------------------------------------------------------
+void PmemCache::initHeader()
+{
+  memset(header, 0, sizeof(Header));
+  memcpy(header->magic, CacheMagic, sizeof(CacheMagic));
+  header->version = Version;
+  header->chipNum = chipNum;
+  header->offset = offset;
+  header->length = length;
+  header->blockSize = blockSize;
+  header->numBlocks = numBlocks;
+  header->valid = 0;
+  strncpy(header->ctlrID, ctlrID.c_str(), sizeof(header->ctlrID) - 1);
+}
+
+//-----------------------------------------------------------------------------
+void PmemCache::blockRange(uint32_t blockIdx, size_t &from, size_t &to) const
+{
+  uint64_t blockStart = (uint64_t(offset) / blockSize + blockIdx) * blockSize;
+  from = max<uint64_t>(blockStart, offset) - offset;
+  to = min<uint64_t>(blockStart + blockSize, uint64_t(offset) + length)
+     - offset;
+}
+
+//-----------------------------------------------------------------------------
+//  Checks every block against its hash before trusting the image, so a file
+//  left half-written (e.g. by an IOC crash) is never republished
+//-----------------------------------------------------------------------------
+bool PmemCache::load(vector<uint8_t> &buf)
+{
+  if (!isOpen() or (header->valid != 1))  return false;
+
+  for (uint32_t blk = 0; blk < numBlocks; ++blk)  {
+    size_t from, to;
+    blockRange(blk, from, to);
+    if (hashBytes(image + from, to - from) != hashes[blk])  {
+      header->valid = 0;  return false; }
+  }
+
+  buf.assign(image, image + length);
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+size_t PmemCache::store(const vector<uint8_t> &buf)
+{
+  if (!isOpen() or (buf.size() != length))  return 0;
+
+  bool wasValid = (header->valid == 1);
+  header->valid = 0;
+
+  size_t numChgd = 0;
+  for (uint32_t blk = 0; blk < numBlocks; ++blk)  {
+    size_t from, to;
+    blockRange(blk, from, to);
+    uint64_t hash = hashBytes(buf.data() + from, to - from);
+    if (wasValid and (hash == hashes[blk]) and
+        !memcmp(image + from, buf.data() + from, to - from))  continue;
+    memcpy(image + from, buf.data() + from, to - from);
+    hashes[blk] = hash;
+    ++numChgd;
+  }
+
+  header->valid = 1;
+  msync(mapAddr, mapSize, MS_ASYNC);
+
+  return numChgd;
+}
+
+//-----------------------------------------------------------------------------
+void PmemCache::invalidate()
+{
+  if (!isOpen() or !header->valid)  return;
+
+  header->valid = 0;
+  msync(mapAddr, mapSize, MS_ASYNC);
+}
+
+//-----------------------------------------------------------------------------
+uint64_t PmemCache::hashBytes(const uint8_t *data, size_t count)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+
+  for (size_t u = 0; u < count; ++u)  {
+    hash ^= data[u];
+    hash *= 0x100000001b3ull;
+  }
+
+  return hash;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,145 @@
+#ifndef PMEMCACHE_H
+#define PMEMCACHE_H
+
+/**
+ * @file  PmemCache.h
+ * @brief Defines a memory-mapped file that keeps the last image read of a
+ *        PMEM array region, so it can be republished without waiting for
+ *        the region to be read again
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <asynDriver.h>
+
+/**
+ * @brief On-disk copy of the last image read of one PMEM region.
+ *
+ * Each file is keyed by the ctlr it was read from and by the region (chip,
+ * offset, length and blockSize) and holds a hash of the image bytes in each
+ * of the region's blocks.  A file with a different key is reinitialized
+ * when opened, and an image is only loaded if all of its blocks still match
+ * their hashes (i.e. the file was not left half-written).
+ *
+ * File layout: Header, one uint64_t hash per block, then the image bytes.
+ */
+class PmemCache {
+public:
+  /**
+   * @brief Constructor for a PmemCache (the file is not opened yet)
+   *
+   * @param[in] ctlrID    identifies the ctlr the region belongs to
+   * @param[in] chipNum   PMEM chip number
+   * @param[in] offset    byte offset of the region in the chip
+   * @param[in] length    # of bytes in the region
+   * @param[in] blockSize # of bytes in each erase/write block of the chip
+   */
+  PmemCache(const std::string &ctlrID, uint32_t chipNum, uint32_t offset,
+            uint32_t length, uint32_t blockSize);
+
+  ~PmemCache();
+
+  PmemCache(const PmemCache &) = delete;
+  PmemCache &operator=(const PmemCache &) = delete;
+
+  /**
+   * @brief Method that opens (creating it if required) and maps the cache
+   *        file for the region in a directory
+   *
+   * @param[in] dir directory for the cache files
+   *
+   * @return asynError if the file can't be created or mapped
+   */
+  asynStatus open(const std::string &dir);
+
+  bool isOpen() const { return image != nullptr; }
+
+  const std::string &getPath() const { return path; }
+
+  /**
+   * @brief Method that copies the cached image if it is valid
+   *
+   * @param[out] buf resized to the length of the region
+   *
+   * @return false if there is no valid image in the file
+   */
+  bool load(std::vector<uint8_t> &buf);
+
+  /**
+   * @brief Method that saves a new image of the region (only the blocks
+   *        whose hash changed are copied)
+   *
+   * @param[in] buf image of the region
+   *
+   * @return # of blocks that changed
+   */
+  size_t store(const std::vector<uint8_t> &buf);
+
+  /**
+   * @brief Method that flags the cached image as no longer valid (e.g.
+   *        while a new value is written to the region)
+   */
+  void invalidate();
+
+  /**
+   * @brief Calculates the hash kept for each block (64-bit FNV-1a)
+   *
+   * @param[in] data  first byte
+   * @param[in] count # of bytes
+   *
+   * @return hash of the bytes
+   */
+  static uint64_t hashBytes(const uint8_t *data, size_t count);
+
+  static const uint32_t Version = 1;  //!< Changed when the file layout changes
+
+#ifndef TEST_DRVFGPDB
+private:
+#endif
+  /**
+   * @brief Fixed-size header at the start of each cache file
+   */
+  struct Header {
+    char      magic[8];    //!< "FGPDBPMC"
+    uint32_t  version;     //!< Version of the file layout
+    uint32_t  chipNum;     //!< key: PMEM chip number
+    uint32_t  offset;      //!< key: byte offset of the region
+    uint32_t  length;      //!< key: # of bytes in the region
+    uint32_t  blockSize;   //!< key: # of bytes in each block
+    uint32_t  numBlocks;   //!< # of blocks the region spans
+    uint32_t  valid;       //!< 1 if the image and hashes are complete
+    char      ctlrID[92];  //!< key: the ctlr (null terminated)
+  };
+  static_assert(sizeof(Header) == 128, "Header must keep its on-disk size");
+
+  /**
+   * @brief Method that returns the range of image bytes in a block
+   *
+   * @param[in]  blockIdx # of the block (from the 1st one of the region)
+   * @param[out] from     index of the 1st image byte in the block
+   * @param[out] to       index after the last image byte in the block
+   */
+  void blockRange(uint32_t blockIdx, size_t &from, size_t &to) const;
+
+  bool keyMatches() const;  //!< true if the file header has this cache's key
+
+  void initHeader();  //!< Writes this cache's key to the header (image invalid)
+
+  std::string  ctlrID;     //!< identifies the ctlr the region belongs to
+  uint32_t     chipNum;    //!< PMEM chip number
+  uint32_t     offset;     //!< byte offset of the region
+  uint32_t     length;     //!< # of bytes in the region
+  uint32_t     blockSize;  //!< # of bytes in each block
+  uint32_t     numBlocks;  //!< # of blocks the region spans
+
+  std::string  path;       //!< path of the cache file
+  void        *mapAddr;    //!< start of the mapped file
+  size_t       mapSize;    //!< # of bytes mapped
+  Header      *header;     //!< header at the start of the mapped file
+  uint64_t    *hashes;     //!< hash of each block's image bytes
+  uint8_t     *image;      //!< image bytes of the region
+};
+
+#endif // PMEMCACHE_H
@@ -6,6 +6,8 @@
  * @brief Defines the C++ interface for accessing the functions in asynOctetSyncIO.
  */
 
+#include <string>
+
 /**
  * @brief struct with all read-related parameters used by asynOctetSyncIOInterface
  * @note  needed because max function arguments supported by google mock is 9
@@ -91,6 +93,98 @@ public:
   virtual asynStatus getOutputEosOnce(const char *port, int addr, char *eos,
                                       int eossize, int *eoslen,
                                       const char *drvInfo) = 0;
+
+  /**
+   * @brief Send several messages.  Implementations that can send all of them
+   *        with a single call override this; by default they are sent one at
+   *        a time using write().
+   *
+   * @param[in]  pasynUser connection to use
+   * @param[in]  outData   the messages to send
+   * @param[in]  numMsgs   # of messages in outData
+   * @param[out] msgsOut   # of messages sent
+   * @param[in]  timeout   max # of secs to wait for each message to be sent
+   *
+   * @return asynSuccess if all messages were sent
+   */
+  virtual asynStatus writeMulti(asynUser *pasynUser, writeData outData[],
+                                size_t numMsgs, size_t *msgsOut,
+                                double timeout)
+  {
+    for (*msgsOut = 0; *msgsOut < numMsgs; ++*msgsOut)  {
+      size_t nbytesOut = 0;
+      asynStatus stat = write(pasynUser, outData[*msgsOut], &nbytesOut,
+                              timeout);
+      if (stat != asynSuccess)  return stat;
+      if (nbytesOut != outData[*msgsOut].write_buffer_len)  return asynError;
+    }
+    return asynSuccess;
+  }
+
+  /**
+   * @brief Receive up to maxMsgs messages, waiting only for the 1st one.
+   *        Implementations that can receive several messages with a single
+   *        call override this; by default one message is read using read().
+   *
+   * @param[in]  pasynUser connection to use
+   * @param[in]  inData    buffers for the messages
+   * @param[out] nbytesIn  # of bytes read in to each buffer
+   * @param[in]  maxMsgs   # of buffers in inData and nbytesIn
+   * @param[out] msgsIn    # of messages read
+   * @param[in]  timeout   max # of secs to wait for the 1st message
+   *
+   * @return asynSuccess, asynTimeout if no message arrived, or an error
+   */
+  virtual asynStatus readMulti(asynUser *pasynUser, readData inData[],
+                               size_t nbytesIn[], size_t maxMsgs,
+                               size_t *msgsIn, double timeout)
+  {
+    int eomReason;
+    *msgsIn = 0;
+    if (!maxMsgs)  return asynSuccess;
+    nbytesIn[0] = 0;
+    asynStatus stat = read(pasynUser, inData[0], &nbytesIn[0], timeout,
+                           &eomReason);
+    if ((stat == asynSuccess) and nbytesIn[0])  *msgsIn = 1;
+    return stat;
+  }
+
+  /**
+   * @brief Connect a 2nd asynUser to the same connection as an existing one,
+   *        so another thread can use the connection at the same time (each
+   *        asynUser keeps the state of its own calls).  By default the new
+   *        asynUser is connected to the port again.
+   *
+   * @param[in]  port       name of the port
+   * @param[in]  addr       address on the port
+   * @param[in]  pasynUser  asynUser already connected to the port
+   * @param[out] ppasynUser new asynUser
+   * @param[in]  drvInfo    driver info string (may be null)
+   *
+   * @return asynSuccess if the new asynUser is connected
+   */
+  virtual asynStatus connectShared(const char *port, int addr,
+                                   __attribute__((unused)) asynUser *pasynUser,
+                                   asynUser **ppasynUser, const char *drvInfo)
+  {
+    return connect(port, addr, ppasynUser, drvInfo);
+  }
+
+  /**
+   * @brief Resolved address of the device a connected asynUser talks to, so
+   *        a device can be told apart from the name of the port used to
+   *        reach it.  By default the address is not known.
+   *
+   * @param[in] pasynUser connected asynUser
+   *
+   * @return {ip}:{port} of the device (empty if not known)
+   */
+  virtual std::string peerAddr(__attribute__((unused)) asynUser *pasynUser)
+  {
+    return std::string();
+  }
+
+  virtual ~asynOctetSyncIOInterface() {}
 };
 
 #endif // ASYNOCTETSYNCIOINTERFACE_H
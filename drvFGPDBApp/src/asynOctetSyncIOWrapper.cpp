@@ -1,7 +1,13 @@
+#include <netdb.h>
+#include <sys/socket.h>
+
 #include <asynOctetSyncIO.h>
+#include <asynOptionSyncIO.h>
 
 #include "asynOctetSyncIOWrapper.h"
 
+using namespace std;
+
 asynStatus asynOctetSyncIOWrapper::connect(const char* port, int addr,
                                            asynUser** ppasynUser,
                                            const char* drvInfo)
@@ -14,6 +20,40 @@ asynStatus asynOctetSyncIOWrapper::disconnect(asynUser* pasynUser)
   return pasynOctetSyncIO->disconnect(pasynUser);
 }
 
+//-----------------------------------------------------------------------------
+//  The hostInfo of a drvAsynIPPort ({host}:{port} [protocol]) is resolved the
+//  same way the port resolves it when it connects
+//-----------------------------------------------------------------------------
+string asynOctetSyncIOWrapper::peerAddr(asynUser *pasynUser)
+{
+  const char *portName = nullptr;
+  char hostInfo[256] = "";
+  if ((pasynManager->getPortName(pasynUser, &portName) != asynSuccess) or
+      !portName or
+      (pasynOptionSyncIO->getOptionOnce(portName, 0, "hostInfo", hostInfo,
+                                        sizeof(hostInfo), 1.0) != asynSuccess))
+    return string();
+
+  string info(hostInfo);
+  info = info.substr(0, info.find_first_of(" \t"));
+  auto sep = info.rfind(':');
+  if (sep == string::npos)  return string();
+
+  addrinfo hints {};
+  hints.ai_family = AF_INET;
+  addrinfo *res = nullptr;
+  if (getaddrinfo(info.substr(0, sep).c_str(), info.substr(sep + 1).c_str(),
+                  &hints, &res) or !res)  return string();
+
+  char host[NI_MAXHOST], service[NI_MAXSERV];
+  int stat = getnameinfo(res->ai_addr, res->ai_addrlen, host, sizeof(host),
+                         service, sizeof(service),
+                         NI_NUMERICHOST | NI_NUMERICSERV);
+  freeaddrinfo(res);
+
+  return stat ? string() : string(host) + ":" + service;
+}
+
 asynStatus asynOctetSyncIOWrapper::write(asynUser* pasynUser, writeData outData,
                                          size_t *nbytesOut, double timeout)
 {
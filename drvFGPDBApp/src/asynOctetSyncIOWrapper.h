@@ -16,6 +16,7 @@ public:
   asynStatus connect(const char *port, int addr, asynUser **ppasynUser,
                              const char *drvInfo) override;
   asynStatus disconnect(asynUser *pasynUser) override;
+  std::string peerAddr(asynUser *pasynUser) override;
   asynStatus write(asynUser *pasynUser, writeData outData, size_t *nbytesOut,
                    double timeout) override;
   asynStatus read(asynUser *pasynUser, readData inData, size_t *nbytesIn,
@@ -23,7 +23,11 @@
 #include <mutex>
 #include <stdexcept>
 #include <list>
+#include <algorithm>
 #include <ctime>
+#include <cmath>
+#include <limits>
+#include <cstring>
 
 #include <boost/format.hpp>
 
@@ -32,6 +36,7 @@
 #include "logger.h"
 
 #include <epicsThread.h>
+#include <alarm.h>
 
 using namespace std;
 using boost::format;
@@ -68,12 +73,18 @@ drvFGPDB::drvFGPDB(const std::string &drvPortName,
                                0.020, timerQueue)),
     arrayWritesTimer(eventTimer(bind(&drvFGPDB::processArrayWrites, this),
                                 0.020, timerQueue)),
+    scalarWritesTimer(eventTimer(bind(&drvFGPDB::processScalarWrites, this),
+                                 0.020, timerQueue)),
+    waveformReadsTimer(eventTimer(bind(&drvFGPDB::processWaveformReads, this),
+                                  1.000, timerQueue)),
     postNewReadingsTimer(eventTimer(bind(&drvFGPDB::postNewReadings, this),
                                     0.200, timerQueue)),
     comStatusTimer(eventTimer(bind(&drvFGPDB::checkComStatus, this),
                               1.000, timerQueue)),
     callback_thread_id(0),
     syncIO(syncIOWrapper),
+    drvValuesChgd(0),
+    allDrvValueBits(0),
     initComplete(false),
     exitDriver(false),
     writeAccess(false),
@@ -82,7 +93,7 @@ drvFGPDB::drvFGPDB(const std::string &drvPortName,
     updateRegs(true),
     firstRestartCheck(true),
     connected(false),
-    lastRespTime(0s),
+    lastRespTime(chrono::system_clock::time_point(0s)),
     lastWriteTime(0s),
     idUpSecs(-1),
     upSecs(0),
@@ -103,10 +114,49 @@ drvFGPDB::drvFGPDB(const std::string &drvPortName,
     stateFlags(0),
     idCtlrUpSince(-1),
     ctlrUpSince(0),
+    idMaxPktsInFlight(-1),
+    maxPktsInFlight(4),
+    idEtherMTU(-1),
+    etherMTU(1500),
+    idProbeMTU(-1),
+    probeMTU(0),
+    mtuProbed(false),
+    probeFailedMTU(0),
+    probeFailedPayload(0),
+    idStreamInterval(-1),
+    streamInterval(0),
+    streamPktID(0),
+    streamActive(false),
+    idWriteWindow(-1),
+    writeWindow(5),
+    idPostWindow(-1),
+    postWindow(5),
+    idWfInterval(-1),
+    wfInterval(1000),
+    idLatePktsRcvd(-1),
+    latePktsRcvd(0),
+    idPmemFullReadback(-1),
+    pmemFullReadback(0),
+    idRegRTT(-1),
+    regRTT(0),
+    idBlockRTT(-1),
+    blockRTT(0),
+    eraseRTTEst(RTTEstimator::EraseMinRTO),
+    rcvBufs(),
+    rcvdPktCount(0),
+    latePktCount(0),
+    numInFlight(0),
+    streamReadCmd(),
+    pollPlans(),
+    pollPlanMTU(0),
+    regMapChgd(true),
+    ctlrAddr(udpPortName),
     resendMode(static_cast<ResendMode>(resendMode_)),
     diagFlags(startupDiagFlags),
     log(pLog)
 {
+  for (auto &rcvBuf : rcvBufs)  rcvBuf.assign(MaxDatagramWords, 0);
+
   if (addRequiredParams() != asynSuccess)  {
     log->fatal(" *** "s + portName + ": Req Params Config error ***\n\n");
     //Exit thread body safely
@@ -124,6 +174,28 @@ drvFGPDB::drvFGPDB(const std::string &drvPortName,
                "port: " + udpPortName + " ***\n\n");
     throw invalid_argument("Invalid asyn UDP port name");
   }
+
+  // The receiver thread reads while the other threads write, so it gets its
+  // own asynUser
+  stat = syncIO->connectShared(udpPortName.c_str(), 0, pAsynUserUDP,
+                               &pAsynUserRcv, nullptr);
+
+  if (stat) {
+    syncIO->disconnect(pAsynUserUDP);
+    log->fatal(" *** "s + portName + ": Unable to connect receiver to asyn " +
+               "UDP port: " + udpPortName + " ***\n\n");
+    throw invalid_argument("Invalid asyn UDP port name");
+  }
+
+  // the PMEM cache files are for the ctlr at this address, whatever the
+  // name of the port used to reach it
+  string peerAddr = syncIO->peerAddr(pAsynUserUDP);
+  if (!peerAddr.empty())  ctlrAddr = peerAddr;
+
+  for (auto scanClass : { ScanClass::Hz10, ScanClass::Hz1, ScanClass::Hz0_1 })
+    scanTimers.push_back(make_unique<eventTimer>(
+        bind(&drvFGPDB::processScanClass, this, scanClass),
+        scanPeriod(scanClass), timerQueue));
 }
 
 //-----------------------------------------------------------------------------
@@ -131,15 +203,21 @@ drvFGPDB::~drvFGPDB()
 {
   exitDriver = true;
 
+  if (rcvThread.joinable())  rcvThread.join();
+
   writeAccessTimer.destroy();
   scalarReadsTimer.destroy();
   arrayReadsTimer.destroy();
   arrayWritesTimer.destroy();
+  scalarWritesTimer.destroy();
+  waveformReadsTimer.destroy();
   postNewReadingsTimer.destroy();
   comStatusTimer.destroy();
+  for (auto &scanTimer : scanTimers)  scanTimer->destroy();
 
   timerQueue.release();
 
+  syncIO->disconnect(pAsynUserRcv);
   syncIO->disconnect(pAsynUserUDP);
 }
 
@@ -156,7 +234,15 @@ void drvFGPDB::completeArrayParamInit (){
       log->major(" *** "s + portName + ": Invalid read/write status " +
                  "parameters for :" + param.name + " *** \n\n");
     }
+
+    if (param.rdRateParamName.empty())  continue;
+    param.rdRateParamID = findParamByName(param.rdRateParamName);
+    if (param.rdRateParamID < 0)
+      log->major(" *** "s + portName + ": Invalid read rate parameter " +
+                 "for :" + param.name + " *** \n\n");
   }
+
+  openPmemCaches();
 }
 
 //-----------------------------------------------------------------------------
@@ -168,9 +254,16 @@ void drvFGPDB::startCommunication()
     return;
   }
 
+  buildPollPlan();
+  buildDrvValueIndex();
+
+  rcvThread = thread(&drvFGPDB::processResponses, this);
+
   writeAccessTimer.start();
   scalarReadsTimer.start();
+  for (auto &scanTimer : scanTimers)  scanTimer->start();
   arrayReadsTimer.start();
+  waveformReadsTimer.start();
   postNewReadingsTimer.start();
   comStatusTimer.start();
 
@@ -212,7 +305,43 @@ double drvFGPDB::processScalarReads()
 
   if (exitDriver)  return DontReschedule;
 
-  updateScalarReadValues();  postNewReadingsTimer.wakeUp();
+  updateStream();
+
+  updateScalarReadValues();
+
+  // Until the ctlr is online the regs in the named scan classes are read
+  // here too (checkComStatus() waits for all the RO/WA regs to be read)
+  if (!connected)
+    for (auto scanClass : { ScanClass::Hz10, ScanClass::Hz1, ScanClass::Hz0_1 })
+      updateScalarReadValues(scanClass);
+
+  schedulePost();
+
+  // look for a larger usable MTU once each time the ctlr comes online
+  if (probeMTU and connected and !mtuProbed)  {
+    probeEtherMTU();  mtuProbed = true; }
+
+  return DefaultInterval;
+}
+
+//-----------------------------------------------------------------------------
+//  Function invoked by the eventTimer thread to update the driver's copy of
+//  the LCP regs in one of the named scan classes.  Until the ctlr is online
+//  processScalarReads() reads them (with the Default scan class), so these
+//  are only read while connected.
+//
+//  WARNING:  This function should ONLY be called by the thread that manages
+//            the eventTimer.
+//-----------------------------------------------------------------------------
+double drvFGPDB::processScanClass(ScanClass scanClass)
+{
+  checkCallbackThread(__func__);
+
+  if (exitDriver)  return DontReschedule;
+
+  if (!connected)  return DefaultInterval;
+
+  updateScalarReadValues(scanClass);  schedulePost();
 
   return DefaultInterval;
 }
@@ -232,26 +361,30 @@ double drvFGPDB::processArrayReads(void)
   checkCallbackThread(__func__);
 
   if (exitDriver)  return DontReschedule;
-  if (!connected)  return 1.0;
-
-  //ToDo: Use a list of array params with pending reads to improve efficiency
 
   arrayReadsInProgress = false;
 
-  for (auto &param : params)  {
-
-    if (! param.isArrayParam())  continue;
+  // Get the array params that can be read now from the set of ones with an
+  // active read (waiting if a new or in-progress write for the same array)
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
 
-    if (param.readState != ReadState::Update)  continue;
+    if (activeArrayReads.empty())  return DontReschedule;
 
-    SetState setState;
-    {
-      lock_guard<drvFGPDB> asynLock(*this);
-      setState = param.setState;
+    arrayReadIDs.clear();
+    for (int paramID : activeArrayReads)  {
+      const ParamInfo &param = params.at(paramID);
+      if (param.readState != ReadState::Update)  continue;
+      if ((param.setState == SetState::Pending) or
+          (param.setState == SetState::Processing))  continue;
+      arrayReadIDs.push_back(paramID);
     }
-    // Wait if a new or in-progress write operation for this array
-    if ((setState == SetState::Pending) or
-        (setState == SetState::Processing))  continue;
+  }
+
+  if (!connected)  return 1.0;
+
+  for (int paramID : arrayReadIDs)  {
+    ParamInfo &param = params.at(paramID);
 
     // start or continue processing an array value
     if (readNextBlock(param) != asynSuccess)  initArrayReadback(param);
@@ -277,31 +410,29 @@ double drvFGPDB::processArrayWrites(void)
 
   if (exitDriver)  return DontReschedule;
 
-  //ToDo: Use a list of array params with pending writes to improve efficiency
-
   arrayWritesInProgress = false;
 
-  for (auto &param : params)  {
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
 
-    // start or continue processing an array value
-    if (! param.isArrayParam())  continue;
+    if (activeArrayWrites.empty())  return DontReschedule;
 
-    SetState setState;
-    {
-      lock_guard<drvFGPDB> asynLock(*this);
-      setState = param.setState;
-    }
-    if ((setState != SetState::Pending) and
-        (setState != SetState::Processing))  continue;
+    arrayWriteIDs.assign(activeArrayWrites.begin(), activeArrayWrites.end());
+  }
+
+  if (!connected or !writeAccess)  return 2.0;
 
-    if (!connected or !writeAccess)  continue;
+  for (int paramID : arrayWriteIDs)  {
+    ParamInfo &param = params.at(paramID);
 
+    // start or continue processing an array value
     if (writeNextBlock(param) != asynSuccess)  {
       log->major(" *** "s + portName + ":" + param.name +
                  ": Unable to write new array value ***\n\n");
       lock_guard<drvFGPDB> asynLock(*this);
-      param.setState = SetState::Error;
-      setParamStatus(ParamID(param), asynError);
+      updateSetting(param, SetState::Error);
+      activeArrayWrites.erase(paramID);
+      setParamStatus(paramID, asynError);
       // always re-read after a write (especially after a failed one!)
       initArrayReadback(param);
     }
@@ -310,6 +441,66 @@ double drvFGPDB::processArrayWrites(void)
   return (arrayWritesInProgress ? DefaultInterval : 2.0);
 }
 
+//-----------------------------------------------------------------------------
+//  Function invoked by the eventTimer thread to send new settings for scalar
+//  LCP register params to the controller.  The writeXxx() funcs only mark a
+//  setting as Pending so that asyn clients never wait for the network.
+//
+//  Returns DefaultInternval or the # of secs until the next call.
+//
+//  WARNING:  This function should ONLY be called by the thread that manages
+//            the eventTimer.  To cause this function to be called by that
+//            thread ASAP, call scalarWritesTimer.wakeUp()
+//-----------------------------------------------------------------------------
+double drvFGPDB::processScalarWrites(void)
+{
+  checkCallbackThread(__func__);
+
+  if (exitDriver)  return DontReschedule;
+
+  if (!connected or !writeAccess)
+    return pendingRegSettings() ? 1.0 : DontReschedule;
+
+  return (writePendingRegs() == asynSuccess) ? DontReschedule : 1.0;
+}
+
+
+//-----------------------------------------------------------------------------
+//  Function invoked by the eventTimer thread to read the ctlr waveforms.
+//
+//  Returns DefaultInternval or the # of secs until the next call.
+//
+//  WARNING:  This function should ONLY be called by the thread that manages
+//            the eventTimer.  To cause this function to be called by that
+//            thread ASAP, call waveformReadsTimer.wakeUp()
+//-----------------------------------------------------------------------------
+double drvFGPDB::processWaveformReads(void)
+{
+  checkCallbackThread(__func__);
+
+  if (exitDriver)  return DontReschedule;
+  if (!connected)  return 1.0;
+
+  U32 interval;
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+    interval = wfInterval;
+  }
+  if (!interval)  return 1.0;
+
+  bool  newReadings = false;
+
+  for (auto &param : params)  {
+
+    if (!param.isWaveformParam())  continue;
+
+    if (readWaveform(param) == asynSuccess)  newReadings = true;
+  }
+
+  if (newReadings)  schedulePost();
+
+  return interval / 1000.0;
+}
 
 //-----------------------------------------------------------------------------
 //  Function invoked by the eventTimer thread to update the state of they asyn
@@ -319,7 +510,8 @@ double drvFGPDB::processArrayWrites(void)
 //
 //  WARNING:  This function should ONLY be called by the thread that manages
 //            the eventTimer.  To cause this function to be called by that
-//            thread ASAP, call postNewReadingsTimer.wakeUp()
+//            thread ASAP, call postNewReadingsTimer.wakeUp() (or schedulePost()
+//            to merge bursts of new readings in to one callback pass)
 //----------------------------------------------------------------------------
 double drvFGPDB::postNewReadings(void)
 {
@@ -330,27 +522,29 @@ double drvFGPDB::postNewReadings(void)
 
   if (exitDriver)  return DontReschedule;
 
-  //ToDo:  Efficiency improvement:
-  //       Eliminate the need to scan the entire list of params each time by
-  //       using a separate list of params that have new read values that need
-  //       to be posted.
-
   lock_guard<drvFGPDB> asynLock(*this);
 
-  for (int paramID=0; (unsigned int)paramID<params.size(); ++paramID)  {
+  // Only the params with new readings are on the pending list.  The ones
+  // that fail to post are added to the (now empty) list again.
+  postingReadings.swap(pendingReadings);
+
+  postBatches.clear();
+  for (int paramID : postingReadings)  {
     ParamInfo &param = params.at(paramID);
+    param.clearOnPendingList();
 
     if (param.readState != ReadState::Pending)  continue;
 
-    stat = setAsynParamVal(paramID);
-
-    if (stat == asynSuccess)  {
-      param.readState = ReadState::Current;
-      chgsToBePosted = true;
-    }
-    setIfNewError(returnStat, stat);
+    postBatches.add(paramID, param.getAsynType());
   }
 
+  postingReadings.clear();
+
+  if (postBatches.empty())  return DefaultInterval;
+
+  stat = publishBatches(chgsToBePosted);
+  setIfNewError(returnStat, stat);
+
   if (chgsToBePosted)  {
     stat = callParamCallbacks();
     setIfNewError(returnStat, stat);
@@ -360,6 +554,62 @@ double drvFGPDB::postNewReadings(void)
 }
 
 
+//-----------------------------------------------------------------------------
+void drvFGPDB::schedulePost(void)
+{
+  postNewReadingsTimer.start(postWindow / 1000.0);
+}
+
+//-----------------------------------------------------------------------------
+//  Pass the new readings to the asyn param library, one asyn type at a time.
+//  The Float64 values are all converted before any are passed on.  Caller
+//  must hold the asyn lock.
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::publishBatches(bool &chgsToBePosted)
+{
+  asynStatus  returnStat = asynSuccess;
+
+  auto finishPost = [&] (int paramID, asynStatus stat) {
+    ParamInfo &param = params.at(paramID);
+    if (stat == asynSuccess)  {
+      param.readState = ReadState::Current;
+      chgsToBePosted = true;
+    }
+    else  param.setReadPending();
+    setIfNewError(returnStat, stat);
+  };
+
+  auto finishScalarPost = [&] (int paramID, asynStatus stat) {
+    if (setParamStatus(paramID, stat) != asynSuccess)  stat = asynError;
+    finishPost(paramID, stat);
+  };
+
+  for (int paramID : postBatches.int32IDs)
+    finishScalarPost(paramID,
+                     setIntegerParam(paramID, params[paramID].ctlrValRead));
+
+  for (int paramID : postBatches.digitalIDs)
+    finishScalarPost(paramID,
+                     setUIntDigitalParam(paramID, params[paramID].ctlrValRead,
+                                         0xFFFFFFFF));
+
+  const vector<int> &float64IDs = postBatches.float64IDs;
+  vector<double> &float64Vals = postBatches.float64Vals;
+  float64Vals.resize(float64IDs.size());
+  for (size_t u=0; u<float64IDs.size(); ++u)  {
+    const ParamInfo &param = params[float64IDs[u]];
+    float64Vals[u] = ParamInfo::ctlrFmtToDouble(param.ctlrValRead,
+                                                param.getCtlrFmt());
+  }
+  for (size_t u=0; u<float64IDs.size(); ++u)
+    finishScalarPost(float64IDs[u], setDoubleParam(float64IDs[u], float64Vals[u]));
+
+  for (int paramID : postBatches.arrayIDs)
+    finishPost(paramID, setAsynParamVal(paramID));
+
+  return returnStat;
+}
+
 //-----------------------------------------------------------------------------
 //  Function invoked by the eventTimer thread to check if the ctlr is connected,
 //  disconnected, or was rebooted.
@@ -377,9 +627,9 @@ double drvFGPDB::checkComStatus(void)
   lock_guard<drvFGPDB> asynLock(*this);
 
   if (connected)  {
-    if (chrono::system_clock::now() - lastRespTime >= 5s)  {
+    if (chrono::system_clock::now() - lastRespTime.load() >= 5s)  {
       log->info(" *** "s + portName + ": Controller offline ***\n\n");
-      resetReadStates();  connected = false;
+      resetReadStates();  connected = false;  mtuProbed = false;
       setStateFlags(eStateFlags::SyncConActive, false);
       setStateFlags(eStateFlags::AllRegsConnected,false);
     }
@@ -395,6 +645,7 @@ double drvFGPDB::checkComStatus(void)
     }
     if (!unreadValues)  {
       log->info(" === "s + portName + ": Controller online ===\n\n");
+      publishCachedArrays();
       connected = true;
       setStateFlags(eStateFlags::SyncConActive, true);
       setStateFlags(eStateFlags::AllRegsConnected,true);
@@ -420,19 +671,33 @@ void drvFGPDB::resetReadStates(void)
 
     else  if (param.isArrayParam())  {
       param.initBlockRW(param.arrayValRead.size());
+      // the ctlr's blocks may have changed while we weren't talking to it
+      param.blockValid.assign(param.blockValid.size(), false);
       param.readState = ReadState::Update;
+      activeArrayReads.insert(paramID);
     }
 
+    else  if (param.isWaveformParam())
+      param.readState = ReadState::Undefined;
+
     setParamStatus(paramID, asynDisconnected);
 
     // required to get status change to process for an array param
     if (param.getAsynType() == asynParamInt8Array)
        doCallbacksInt8Array((epicsInt8 *)"", 0, paramID, 0);
+    else  if (param.isWaveformParam())
+       doWaveformCallbacks(param, 0);
   }
 
   setStateFlags(eStateFlags::AllRegsConnected, false);
 
   callParamCallbacks();
+
+  for (auto &group : procGroup)  group.markAllUnread();
+
+  drvValuesChgd = allDrvValueBits;  // so they are all posted again
+
+  if (!activeArrayReads.empty())  arrayReadsTimer.start();
 }
 
 //-----------------------------------------------------------------------------
@@ -442,13 +707,17 @@ void drvFGPDB::resetSetStates(void)
 {
   lock_guard<drvFGPDB> asynLock(*this);
 
-  for (auto &param : params)  {
-    if ( (LCPUtil::addrGroupID(param.getRegAddr()) == ProcGroup_LCP_WA) and
-        ((param.setState == SetState::Processing) or
-         (param.setState == SetState::Restored) or
-         (param.setState == SetState::Sent)) )
-      param.setState = SetState::Pending;
+  ProcGroup &group = getProcGroup(ProcGroup_LCP_WA);
+
+  for (size_t offset=0; offset<group.setStates.size(); ++offset)  {
+    SetState setState = static_cast<SetState>(group.setStates[offset]);
+    if ((setState == SetState::Processing) or
+        (setState == SetState::Restored) or
+        (setState == SetState::Sent))
+      updateSetting(params.at(group.paramIDs[offset]), SetState::Pending);
   }
+
+  scalarWritesTimer.wakeUp();
 }
 
 //-----------------------------------------------------------------------------
@@ -458,11 +727,47 @@ void drvFGPDB::clearSetStates(void)
 {
   lock_guard<drvFGPDB> asynLock(*this);
 
-  for (auto &param : params)  {
-    if ( (LCPUtil::addrGroupID(param.getRegAddr()) == ProcGroup_LCP_WA) and
-        (param.setState == SetState::Restored) )
-      param.setState = SetState::Sent;
+  ProcGroup &group = getProcGroup(ProcGroup_LCP_WA);
+
+  for (size_t offset=0;
+       (offset = group.findSetState(offset, SetState::Restored))
+         < group.setStates.size(); ++offset)
+    updateSetting(params.at(group.paramIDs[offset]), SetState::Sent);
+}
+
+//-----------------------------------------------------------------------------
+//  Change the setState of a param and keep the shadow of the settings in its
+//  ProcGroup in sync with it.  Caller must hold the asyn lock.
+//-----------------------------------------------------------------------------
+void drvFGPDB::updateSetting(ParamInfo &param, SetState newState)
+{
+  param.setState = newState;  // the only place a setState is changed
+
+  auto addr = param.getRegAddr();
+  if (!param.isScalarParam() or !LCPUtil::isLCPRegParam(addr))  return;
+
+  ProcGroup &group = getProcGroup(LCPUtil::addrGroupID(addr));
+  unsigned int offset = LCPUtil::addrOffset(addr);
+  if (offset >= group.setStates.size())  return;  // reg map not updated yet
+
+  group.setVals[offset] = param.ctlrValSet;
+  group.setStates[offset] = static_cast<uint8_t>(newState);
+}
+
+//-----------------------------------------------------------------------------
+//  Returns true if any LCP reg has a Pending setting
+//-----------------------------------------------------------------------------
+bool drvFGPDB::pendingRegSettings(void)
+{
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  for (auto groupID : { ProcGroup_LCP_WA, ProcGroup_LCP_WO })  {
+    const ProcGroup &group = getProcGroup(groupID);
+    if (group.findSetState(0, SetState::Pending) < group.setStates.size())
+      return true;
   }
+
+  return false;
 }
 
 //-----------------------------------------------------------------------------
@@ -471,28 +776,21 @@ void drvFGPDB::clearSetStates(void)
 //-----------------------------------------------------------------------------
 void drvFGPDB::cancelArrayWrites(void)
 {
-  //ToDo: Use a list of array params with active writes to improve efficiency
-
   arrayWritesInProgress = false;
 
-  for (auto &param : params)  {
-    if (! param.isArrayParam())  continue;
-
-    {
-      lock_guard<drvFGPDB> asynLock(*this);
+  lock_guard<drvFGPDB> asynLock(*this);
 
-      if ((param.setState != SetState::Pending) and
-          (param.setState != SetState::Processing))  continue;
+  for (int paramID : activeArrayWrites)  {
+    ParamInfo &param = params.at(paramID);
 
-      param.setState = SetState::Error;
-      setParamStatus(ParamID(param), asynError);
-    }
+    updateSetting(param, SetState::Error);
+    setParamStatus(paramID, asynError);
 
     log->info(" *** "s + portName + ":" + param.name +
               ": Write canceled ***\n\n");
-
   }
 
+  activeArrayWrites.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -502,7 +800,7 @@ void drvFGPDB::cancelArrayWrites(void)
 //-----------------------------------------------------------------------------
 void drvFGPDB::checkForRestart(uint32_t newUpSecs)
 {
-  uint32_t readTime = (uint32_t) chrono::system_clock::to_time_t(lastRespTime);
+  uint32_t readTime = (uint32_t) chrono::system_clock::to_time_t(lastRespTime.load());
 
   ParamInfo &upSinceParam = params.at(idCtlrUpSince);
 
@@ -513,12 +811,14 @@ void drvFGPDB::checkForRestart(uint32_t newUpSecs)
   time_t upSince = (time_t) newUpSince;
 
   // If ctlr restarted, resend all the scalar settings (if configured to do so)
-  // and cancel all array writes
+  // and cancel all array writes.  The cached PMEM images can't be trusted
+  // either (e.g. the ctlr may have loaded new contents).
   if ((int32_t)(newUpSince - prevUpSince) > 3)  {
     log->info(" *** "s + portName + ": Controller restarted ***\n\n");
     writeAccess=false;
     if (resendMode == ResendMode::AfterCtlrRestart)  resetSetStates();
     cancelArrayWrites();  resetReadStates();
+    for (auto &entry : pmemCaches)  entry.second->invalidate();
     writeAccessTimer.wakeUp();
   }
   else {
@@ -588,13 +888,15 @@ double drvFGPDB::WriteAccessHandler(void)
   if (exitDriver)  return DontReschedule;
   if (!connected)  return DefaultInterval;
 
-  lock_guard<drvFGPDB> asynlock(*this);
+  // NOTE: No asyn lock here.  The retries can take a while and
+  //       sendCmdsGetResps() takes the lock only to apply the responses.
 
   if (!writeAccess) {
     if (ShowRegWrites())  {
       log->info(" === "s + portName + ": Getting write access ===\n");
     }
     if (getWriteAccess() != asynSuccess)  return 1.0;
+    scalarWritesTimer.wakeUp();  // send any settings that were waiting
     return DefaultInterval;
   }
   else{
@@ -637,7 +939,9 @@ asynStatus drvFGPDB::addRequiredParams(void)
    * @note  Driver-Only values:\n
    *        Use addr=0x1 for Read-Only, addr=0x2 for Read/Write.\n
    *        - syncPktID, syncPktsSent, syncPktsRcvd, asyncPktID, asyncPktsSent
-   *          and asyncPktsRcvd, ctlrUpSince
+   *          and asyncPktsRcvd, ctlrUpSince, maxPktsInFlight, latePktsRcvd,
+   *          regRTT, blockRTT, etherMTU, probeMTU, streamInterval,
+   *          writeWindow, postWindow, wfInterval and pmemFullReadback
    */
   const std::list<RequiredParam> requiredParamDefs = {
     //--- reg values the ctlr must support ---
@@ -660,6 +964,21 @@ asynStatus drvFGPDB::addRequiredParams(void)
     { idDiagFlags,     &diagFlags,     "diagFlags      0x2 UInt32Digital NotDefined" },
 
     { idCtlrUpSince,   &ctlrUpSince,   "ctlrUpSince    0x2 Int32         NotDefined" },
+
+    { idMaxPktsInFlight, &maxPktsInFlight, "maxPktsInFlight 0x2 Int32      NotDefined" },
+    { idLatePktsRcvd,  &latePktsRcvd,  "latePktsRcvd   0x1 Int32         NotDefined" },
+    { idPmemFullReadback, &pmemFullReadback, "pmemFullReadback 0x2 Int32     NotDefined" },
+
+    { idRegRTT,        &regRTT,        "regRTT         0x1 Int32         NotDefined" },
+    { idBlockRTT,      &blockRTT,      "blockRTT       0x1 Int32         NotDefined" },
+
+    { idEtherMTU,      &etherMTU,      "etherMTU       0x2 Int32         NotDefined" },
+    { idProbeMTU,      &probeMTU,      "probeMTU       0x2 Int32         NotDefined" },
+
+    { idStreamInterval, &streamInterval, "streamInterval 0x2 Int32        NotDefined" },
+    { idWriteWindow,   &writeWindow,   "writeWindow    0x2 Int32         NotDefined" },
+    { idPostWindow,    &postWindow,    "postWindow     0x2 Int32         NotDefined" },
+    { idWfInterval,    &wfInterval,    "wfInterval     0x2 Int32         NotDefined" },
  };
 
   for (auto const &paramDef : requiredParamDefs)  {
@@ -718,6 +1037,7 @@ void drvFGPDB::setStateFlags(eStateFlags bitPos, bool value)
   std::bitset<32> setVal(stateFlags);
   setVal.set(static_cast<size_t>(bitPos), value);
   stateFlags = setVal.to_ulong();
+  drvValueChgd(idStateFlags);
 }
 
 //-----------------------------------------------------------------------------
@@ -757,6 +1077,11 @@ int drvFGPDB::addNewParam(const ParamInfo &newParam)
   }
 
   params.push_back(newParam);
+  params.back().setPendingList(&pendingReadings, paramID);
+
+  // a PMEM array value is read as soon as the ctlr is online
+  if (newParam.isArrayParam() and (newParam.readState == ReadState::Update))
+    activeArrayReads.insert(paramID);
 
   if ((unsigned int)paramID != params.size() - 1)  {
     log->fatal(" *** "s + portName + ": param " + newParam.name +
@@ -795,6 +1120,9 @@ int drvFGPDB::processParamDef(const string &paramDef)
                 to_string(paramID) + "] " + newParam.name +
                 " with string def: [" + oss.str() + "] ***\n");
   }
+  // the param's scan class might have changed
+  if (paramDefSt == paramDefState::Updated)  regMapChgd = true;
+
   if (newParam.getRegAddr())
     if ((stat = updateRegMap(paramID)) != asynSuccess)  return -1;
 
@@ -822,6 +1150,73 @@ asynStatus drvFGPDB::drvUserCreate(asynUser *pasynUser, const char *drvInfo,
   }
 }
 
+//-----------------------------------------------------------------------------
+void PostBatches::add(int paramID, asynParamType asynType)
+{
+  switch (asynType)  {
+    case asynParamInt32:          int32IDs.push_back(paramID);    break;
+    case asynParamUInt32Digital:  digitalIDs.push_back(paramID);  break;
+    case asynParamFloat64:        float64IDs.push_back(paramID);  break;
+    default:                      arrayIDs.push_back(paramID);    break;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void PostBatches::clear()
+{
+  int32IDs.clear();  digitalIDs.clear();  float64IDs.clear();
+  float64Vals.clear();  arrayIDs.clear();
+}
+
+//-----------------------------------------------------------------------------
+void ProcGroup::resizeShadow()
+{
+  size_t oldSize = respShadow.size(), newSize = paramIDs.size();
+
+  if (oldSize == newSize)  return;
+
+  respShadow.resize(newSize, 0);
+  unreadBits.resize((newSize + 63) / 64, 0);
+  setVals.resize(newSize, 0);
+  setStates.resize(newSize, static_cast<uint8_t>(SetState::Undefined));
+
+  for (size_t u=oldSize; u<newSize; ++u)
+    unreadBits[u / 64] |= uint64_t(1) << (u % 64);
+}
+
+//-----------------------------------------------------------------------------
+void ProcGroup::markAllUnread()
+{
+  fill(unreadBits.begin(), unreadBits.end(), ~uint64_t(0));
+}
+
+//-----------------------------------------------------------------------------
+bool ProcGroup::anyUnread(size_t first, size_t count) const
+{
+  for (size_t u=first, end=first+count; u<end; )  {
+    size_t bit = u % 64, numBits = min(64 - bit, end - u);
+    uint64_t mask = (numBits == 64) ? ~uint64_t(0) :
+                                      ((uint64_t(1) << numBits) - 1) << bit;
+    if (unreadBits.at(u / 64) & mask)  return true;
+    u += numBits;
+  }
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+size_t ProcGroup::findSetState(size_t first, SetState state) const
+{
+  if (first >= setStates.size())  return setStates.size();
+
+  const uint8_t *start = setStates.data();
+  const void *found = memchr(start + first, static_cast<uint8_t>(state),
+                             setStates.size() - first);
+
+  return found ? (static_cast<const uint8_t *>(found) - start)
+               : setStates.size();
+}
+
 //-----------------------------------------------------------------------------
 // Returns a reference to a ProcGroup object for the specified groupID.
 //-----------------------------------------------------------------------------
@@ -861,12 +1256,20 @@ asynStatus drvFGPDB::updateRegMap(int paramID)
   unsigned int offset = LCPUtil::addrOffset(addr);
 
   if (LCPUtil::isLCPRegParam(addr))  { // ref to LCP register value
-    vector<int> &paramIDs = getProcGroup(groupID).paramIDs;
+    ProcGroup &group = getProcGroup(groupID);
+    vector<int> &paramIDs = group.paramIDs;
 
     if (offset >= paramIDs.size())  paramIDs.resize(offset+1, -1);
 
     if (paramIDs.at(offset) < 0) {  // not set yet
-      paramIDs.at(offset) = paramID;  return asynSuccess; }
+      paramIDs.at(offset) = paramID;  regMapChgd = true;
+      group.resizeShadow();
+      if (param.isScalarParam())  {
+        group.setVals[offset] = param.ctlrValSet;
+        group.setStates[offset] = static_cast<uint8_t>(param.setState);
+      }
+      return asynSuccess;
+    }
 
     if (paramIDs.at(offset) == paramID)  return asynSuccess;
 
@@ -902,15 +1305,43 @@ asynStatus drvFGPDB::sendMsg(asynUser *pComPort, vector<uint32_t> &cmdBuf)
     .write_buffer_len = bytesToSend,
   };
   asynStatus stat = syncIO->write(pComPort, outData, &bytesSent, writeTimeout);
-  ++syncPktsSent;
+  ++syncPktsSent;  drvValueChgd(idSyncPktsSent);
   if (stat != asynSuccess)  return stat;
   if (bytesSent != bytesToSend)  return asynError;
 
   return asynSuccess;
 }
 
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::sendMsgs(asynUser *pComPort, vector<uint32_t> * const cmdBufs[],
+                              size_t numMsgs)
+{
+  array<writeData, MaxPktsInFlight>  outData;
+  size_t  msgsSent = 0;
+
+  if (numMsgs > MaxPktsInFlight)  return asynError;
+
+  for (size_t u=0; u<numMsgs; ++u)  {
+    outData.at(u).write_buffer = reinterpret_cast<char *>(cmdBufs[u]->data());
+    outData.at(u).write_buffer_len = cmdBufs[u]->size() * sizeof(uint32_t);
+  }
+
+  asynStatus stat = syncIO->writeMulti(pComPort, outData.data(), numMsgs,
+                                       &msgsSent, writeTimeout);
+  syncPktsSent += msgsSent;  drvValueChgd(idSyncPktsSent);
+
+  return stat;
+}
+
 //----------------------------------------------------------------------------
 size_t drvFGPDB::readResp(asynUser *pComPort, vector<uint32_t> &respBuf)
+{
+  return readResp(pComPort, respBuf, readTimeout);
+}
+
+//----------------------------------------------------------------------------
+size_t drvFGPDB::readResp(asynUser *pComPort, vector<uint32_t> &respBuf,
+                          double timeout)
 {
   asynStatus stat;
   int  eomReason;
@@ -920,9 +1351,9 @@ size_t drvFGPDB::readResp(asynUser *pComPort, vector<uint32_t> &respBuf)
     .read_buffer = reinterpret_cast<char *>(respBuf.data()),
     .read_buffer_len = respBuf.size() * sizeof(respBuf[0])
   };
-  stat = syncIO->read(pComPort, inData, &rcvd, readTimeout, &eomReason);
+  stat = syncIO->read(pComPort, inData, &rcvd, timeout, &eomReason);
   if (stat != asynSuccess && stat != asynTimeout)  return -1;
-  if (rcvd) ++syncPktsRcvd;
+  if (rcvd)  { ++rcvdPktCount;  drvValueChgd(idSyncPktsRcvd); }
 
   return rcvd;
 }
@@ -934,104 +1365,631 @@ asynStatus drvFGPDB::sendCmdGetResp(asynUser *pComPort,
                                     LCPCmdBase &LCPCmd,
                                     LCPStatus &respStatus)
 {
-  lock_guard<drvFGPDB> asynLock(*this);
+  LCPCmdBase * const LCPCmds[] = { &LCPCmd };
 
-  asynStatus  stat;
-  int  flushedPkts;
-
-  ++syncPktID;  LCPCmd.setCmdPktID(syncPktID); respStatus = LCPStatus::ERROR;
+  asynStatus stat = sendCmdsGetResps(pComPort, LCPCmds, 1);
 
-  const int MaxMsgAttempts = 5;
-  for (int attempt=0; attempt<MaxMsgAttempts; ++attempt)  {
+  respStatus = LCPCmd.respRcvd() ? LCPCmd.getRespStatus() : LCPStatus::ERROR;
 
-    stat = sendMsg(pComPort, LCPCmd.getCmdBuf());
-
-    if (exitDriver)  return asynError;
-    if (stat != asynSuccess)  {
-        comStatusTimer.wakeUp();  this_thread::sleep_for(100ms);  continue; }
+  return stat;
+}
 
-    bool validResp = false;
-    for (flushedPkts=0; flushedPkts<100; ++flushedPkts)  {
+//-----------------------------------------------------------------------------
+//  dispatchResp() routes any packet with the AsyncPktIDFlag bit set to the
+//  stream, so the sync IDs must wrap before they reach it.  0 is skipped
+//  because it is the value before any cmd was sent.
+//-----------------------------------------------------------------------------
+uint32_t drvFGPDB::nextSyncPktID(void)
+{
+  syncPktID = (syncPktID + 1) & ~AsyncPktIDFlag;
+  if (!syncPktID)  syncPktID = 1;
+  drvValueChgd(idSyncPktID);
 
-      int respLen = readResp(pComPort, LCPCmd.getRespBuf());
+  return syncPktID;
+}
 
-      if ((LCPCmd.getRespLCPCommand()==static_cast<int>(LCPCommand::READ_REGS)) and (static_cast<int>(LCPCmd.getRespBuffSize())!=respLen)){
-        setStateFlags(eStateFlags::AllRegsConnected, false);
-      }
+//-----------------------------------------------------------------------------
+//  Send a list of cmds to the ctlr, keeping up to maxPktsInFlight of them
+//  waiting for a response at the same time.  Each response is matched to its
+//  cmd using the packet ID (by rcvPkts(), normally called by the receiver
+//  thread).  A cmd that does not get a response is resent (using the same
+//  packet ID) until it gets one or MaxMsgAttempts is reached.  How long to
+//  wait for each response is based on the RTT measured for similar cmds.
+//
+//  The asyn lock is NOT held while waiting for the network (only while the
+//  driver state is updated for the responses), so callers must not hold it
+//  either.
+//
+//  For use by synchronous (1 resp for each cmd) thread only!
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::sendCmdsGetResps(asynUser *pComPort,
+                                      LCPCmdBase * const LCPCmds[],
+                                      size_t numCmds, int maxAttempts,
+                                      double respTimeout)
+{
+  lock_guard<mutex> syncIOLock(syncIOMutex);
 
-      if (exitDriver)  return asynError;
-      if (respLen <= 0)  break;
+  asynStatus  returnStat = asynSuccess;
 
-      lastRespTime = chrono::system_clock::now();
-      // check values common to all commands
-      U32 pktIDSent = LCPCmd.getCmdPktID();     U32 pktIDRcvd = LCPCmd.getRespPktID();
-      U32 cmdSent = LCPCmd.getCmdLCPCommand();  U32 cmdRcvd = LCPCmd.getRespLCPCommand();
+  auto toDuration = [] (double delay) {
+    return chrono::duration_cast<chrono::steady_clock::duration>(
+             chrono::duration<double>(delay)); };
 
-      if ((pktIDSent == pktIDRcvd) and (cmdSent == cmdRcvd))  {
-        validResp = true;  break;
-      }
-    }
+  size_t window = maxPktsInFlight;
+  if (window < 1)  window = 1;
+  if (window > MaxPktsInFlight)  window = MaxPktsInFlight;
 
-    if (flushedPkts)  {
-      log->info(" *** "s + portName + ": Flushed " + to_string(flushedPkts) +
-                " old packets ***\n");
-    }
+  size_t  nextCmd = 0;
 
-    // try sending the cmd again if we did't get a valid resp
-    if (!validResp)  {
-        comStatusTimer.wakeUp();  this_thread::sleep_for(100ms);  continue; }
+  unique_lock<mutex> rcvLock(rcvMutex);
 
-    U32 respSessionID = LCPCmd.getRespSessionID();
-    respStatus = LCPCmd.getRespStatus();
+  while ((numInFlight > 0) or (nextCmd < numCmds))  {
 
-    bool prevWriteAccess = writeAccess;
+    if (exitDriver)  break;
 
-    writeAccess = (respSessionID == sessionID.get());
-    if (prevWriteAccess != writeAccess)  {
-      setStateFlags(eStateFlags::WriteAccess, writeAccess);
-      if (writeAccess)
-        log->info(" === "s + portName + ": Now has write access ===\n\n");
-      else
-        log->info(" *** "s + portName + ": Lost write access ***\n\n");
+    // Add cmds to the list of outstanding ones until the window is full
+    while ((numInFlight < window) and (nextCmd < numCmds))  {
+      InFlightCmd &newCmd = inFlight.at(numInFlight++);
+      newCmd.LCPCmd = LCPCmds[nextCmd++];
+      newCmd.pktID = nextSyncPktID();
+      newCmd.attempts = 0;
+      newCmd.resendTime = chrono::steady_clock::now();
+      newCmd.LCPCmd->setCmdPktID(newCmd.pktID);  newCmd.LCPCmd->invalidateResp();
     }
-    return asynSuccess;
-  }
-  return asynError;
-}
 
+    // Finish the cmds that got a response, (re)send the ones that are due,
+    // and find out how long we can wait for the next response
+    auto now = chrono::steady_clock::now();
+    auto waitUntil = now + toDuration(max(RTTEstimator::MaxRTO, respTimeout));
 
-//----------------------------------------------------------------------------
-//  Update the read state of the scalar ParamInfo objects
-//----------------------------------------------------------------------------
-asynStatus drvFGPDB::updateScalarReadValues()
-{
-  // For LCP regs: Read the latest values from the controller
-  readRegs(0x10000, procGroupSize(ProcGroup_LCP_RO));
-  readRegs(0x20000, procGroupSize(ProcGroup_LCP_WA));
-  readRegs(0x30000, procGroupSize(ProcGroup_LCP_WO));
+    array<vector<uint32_t> *, MaxPktsInFlight>  sendBufs;
+    size_t  numToSend = 0;
 
-  lock_guard<drvFGPDB> asynLock(*this);
+    array<InFlightCmd, MaxPktsInFlight>  done;
+    size_t  numDone = 0;
 
-  //ToDo:  Efficiency Improvement:
-  //       Use a list of the scalar params with an associated local variable
-  //       (drvValue != null) to avoid having to scan the entire list each
-  //       time.
+    for (size_t u=0; u<numInFlight; )  {
+      InFlightCmd &cmd = inFlight.at(u);
+      LCPCmdBase &LCPCmd = *cmd.LCPCmd;
 
-  // For driver-only params: Read the latest value from a local variable
-  for (auto &param : params)  {
+      if (LCPCmd.getRespLen())  {
+        done.at(numDone++) = cmd;
+        inFlight.at(u) = inFlight.at(--numInFlight);  continue;
+      }
+
+      if (cmd.resendTime <= now)  {
+        if (cmd.attempts >= maxAttempts)  {  // give up on this cmd
+          returnStat = asynError;
+          inFlight.at(u) = inFlight.at(--numInFlight);  continue;
+        }
+        if (cmd.attempts)  comStatusTimer.wakeUp();
+        ++cmd.attempts;
+        sendBufs.at(numToSend++) = &LCPCmd.getCmdBuf();
+        cmd.sendTime = now;
+        cmd.resendTime = now + toDuration((respTimeout > 0.0) ? respTimeout :
+                                  rttEstimator(LCPCmd).getRTO(cmd.attempts));
+      }
+
+      waitUntil = min(waitUntil, cmd.resendTime);  ++u;
+    }
+
+    // send all the cmds that are due at once and update the driver state
+    // for the ones that are done
+    if (numToSend or numDone)  {
+      rcvLock.unlock();
+      if (numToSend and
+          (sendMsgs(pComPort, sendBufs.data(), numToSend) != asynSuccess))
+        comStatusTimer.wakeUp();
+      if (numDone)  finishCmds(done.data(), numDone);
+      rcvLock.lock();
+    }
+
+    if (!numInFlight)  continue;
+
+    // Wait for the next response
+    auto gotResp = [&] { return exitDriver or any_of(inFlight.begin(),
+                           inFlight.begin() + numInFlight,
+                           [] (const InFlightCmd &cmd) { return cmd.LCPCmd->getRespLen() > 0; }); };
+
+    if (rcvThread.joinable())
+      rcvCond.wait_until(rcvLock, waitUntil, gotResp);
+    else  {  // no receiver thread (yet), so read the response ourselves
+      chrono::duration<double> timeout = waitUntil - chrono::steady_clock::now();
+      rcvLock.unlock();
+      rcvPkts(pComPort, max(timeout.count(), 0.0));
+      rcvLock.lock();
+    }
+  }
+
+  // don't leave anything for rcvPkts() to match if we quit early
+  numInFlight = 0;
+
+  return (exitDriver ? asynError : returnStat);
+}
+
+//-----------------------------------------------------------------------------
+//  Update the driver state for cmds that got a response
+//-----------------------------------------------------------------------------
+void drvFGPDB::finishCmds(const InFlightCmd doneCmds[], size_t numDone)
+{
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  for (size_t u=0; u<numDone; ++u)  {
+    const InFlightCmd &cmd = doneCmds[u];
+    LCPCmdBase &LCPCmd = *cmd.LCPCmd;
+
+    if ((LCPCmd.getCmdLCPCommand() == static_cast<U32>(LCPCommand::READ_REGS))
+        and (LCPCmd.getRespBuffSize() != LCPCmd.getRespLen()))
+      setStateFlags(eStateFlags::AllRegsConnected, false);
+
+    updateWriteAccess(LCPCmd.getRespSessionID());
+    if (cmd.attempts == 1)  updateRTT(cmd);
+  }
+}
+
+//-----------------------------------------------------------------------------
+//  Body of the receiver thread
+//-----------------------------------------------------------------------------
+void drvFGPDB::processResponses(void)
+{
+  while (!exitDriver)  {
+    // avoid spinning if the port is not usable
+    if (rcvPkts(pAsynUserRcv, rcvPollTimeout) < 0)  this_thread::sleep_for(10ms);
+  }
+}
+
+//-----------------------------------------------------------------------------
+//  Read the datagrams from the ctlr that are ready (waiting for the 1st one if
+//  necessary) and pass each of them to the cmd it is a response to
+//-----------------------------------------------------------------------------
+int drvFGPDB::rcvPkts(asynUser *pComPort, double timeout)
+{
+  array<readData, RcvBatchSize>  inData;
+  array<size_t, RcvBatchSize>  rcvd;
+  size_t  numRcvd = 0;
+
+  for (size_t u=0; u<RcvBatchSize; ++u)  {
+    inData.at(u).read_buffer = reinterpret_cast<char *>(rcvBufs.at(u).data());
+    inData.at(u).read_buffer_len = rcvBufs.at(u).size() * sizeof(uint32_t);
+  }
+
+  asynStatus stat = syncIO->readMulti(pComPort, inData.data(), rcvd.data(),
+                                      RcvBatchSize, &numRcvd, timeout);
+  if (stat != asynSuccess && stat != asynTimeout)  return -1;
+
+  size_t  numLate = 0;
+  for (size_t u=0; u<numRcvd; ++u)
+    if (!dispatchResp(rcvBufs.at(u), rcvd.at(u)))  ++numLate;
+
+  // (updateScalarReadValues() copies the counts to their driver values)
+  if (numRcvd)  { rcvdPktCount += numRcvd;  drvValueChgd(idSyncPktsRcvd); }
+  if (numLate)  { latePktCount += numLate;  drvValueChgd(idLatePktsRcvd); }
+
+  return numRcvd;
+}
+
+//-----------------------------------------------------------------------------
+//  Copy a datagram in to the respBuf of the in-flight cmd it is a response to
+//  (if any)
+//-----------------------------------------------------------------------------
+bool drvFGPDB::dispatchResp(const vector<uint32_t> &rcvBuf, size_t respLen)
+{
+  if (respLen < 2 * sizeof(rcvBuf[0]))  return false;
+
+  U32 pktIDRcvd = ntohl(rcvBuf.at(0));  U32 cmdRcvd = ntohl(rcvBuf.at(1));
+
+  // values pushed by the ctlr for a stream subscription
+  if (pktIDRcvd & AsyncPktIDFlag)  {
+    applyStreamResp(rcvBuf, respLen);  return true; }
+
+  lock_guard<mutex> rcvLock(rcvMutex);
+
+  for (size_t u=0; u<numInFlight; ++u)  {
+    InFlightCmd &cmd = inFlight.at(u);
+    if ((cmd.pktID != pktIDRcvd) or cmd.LCPCmd->getRespLen() or
+        (cmd.LCPCmd->getCmdLCPCommand() != cmdRcvd))  continue;
+
+    lastRespTime = chrono::system_clock::now();
+    cmd.rcvTime = chrono::steady_clock::now();
+
+    vector<uint32_t> &respBuf = cmd.LCPCmd->getRespBuf();
+    memcpy(respBuf.data(), rcvBuf.data(),
+           min(respLen, cmd.LCPCmd->getRespBuffSize()));
+    cmd.LCPCmd->setRespLen(respLen);
+
+    rcvCond.notify_one();
+    return true;
+  }
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+//  Manage the subscription for the RO group values pushed by the ctlr.  A
+//  stream that stops (e.g. because the ctlr restarted) is requested again,
+//  and the RO group is polled until the values arrive again.
+//-----------------------------------------------------------------------------
+void drvFGPDB::updateStream(void)
+{
+  auto now = chrono::steady_clock::now();
+
+  uint32_t interval;
+  bool  resubscribe;
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+
+    interval = connected ? streamInterval : 0;
+
+    auto maxGap = max(chrono::milliseconds(3 * interval), chrono::milliseconds(1000));
+    bool stale = (now - lastStreamTime > maxGap);
+
+    if (streamActive and stale)  {
+      log->info(" *** "s + portName + ": Stream of RO values stopped ***\n\n");
+      streamActive = false;
+      setStateFlags(eStateFlags::AsyncConActive, false);
+    }
+
+    if (!interval)  {
+      if (!streamPktID)  return;
+      streamPktID = 0;  streamActive = false;
+      setStateFlags(eStateFlags::AsyncConActive, false);
+      resubscribe = false;
+    }
+    else
+      resubscribe = !streamPktID or
+                    (streamReadCmd->getCmdBufData(4) != interval) or
+                    (streamReadCmd->getCount() != procGroupSize(ProcGroup_LCP_RO)) or
+                    (stale and (now - lastStreamReq >= maxGap));
+  }
+
+  if (interval and !resubscribe)  return;
+
+  sendStreamReq(interval);
+}
+
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::sendStreamReq(uint32_t interval)
+{
+  writeData  outData;
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+
+    streamReadCmd = make_unique<LCPReadRegs>(0x10000,
+                                             procGroupSize(ProcGroup_LCP_RO),
+                                             interval);
+    ++asyncPktID;  drvValueChgd(idAsyncPktID);
+    streamReadCmd->setCmdPktID(AsyncPktIDFlag | asyncPktID);
+    streamPktID = interval ? (AsyncPktIDFlag | asyncPktID) : 0;
+    lastStreamReq = chrono::steady_clock::now();
+
+    vector<uint32_t> &cmdBuf = streamReadCmd->getCmdBuf();
+    outData.write_buffer = reinterpret_cast<char *>(cmdBuf.data());
+    outData.write_buffer_len = cmdBuf.size() * sizeof(cmdBuf[0]);
+  }
+
+  if (ShowRegReads())  {
+    log->info(str(format(" === %s: streamRegs(0x%.8X, %d, %d ms) ===\n") %
+                  portName % 0x10000 % procGroupSize(ProcGroup_LCP_RO) %
+                  interval));
+  }
+
+  // NOTE: streamReadCmd is only replaced by this (eventTimer) thread
+  size_t  bytesSent;
+  asynStatus stat = syncIO->write(pAsynUserUDP, outData, &bytesSent,
+                                  writeTimeout);
+  if (stat == asynSuccess)  { ++asyncPktsSent;  drvValueChgd(idAsyncPktsSent); }
+
+  return stat;
+}
+
+//-----------------------------------------------------------------------------
+//  Apply the RO group values pushed by the ctlr (for the current stream
+//  subscription only)
+//-----------------------------------------------------------------------------
+void drvFGPDB::applyStreamResp(const vector<uint32_t> &rcvBuf, size_t respLen)
+{
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  ++asyncPktsRcvd;  drvValueChgd(idAsyncPktsRcvd);
+
+  if (!streamPktID or (ntohl(rcvBuf.at(0)) != streamPktID))  return;
+  if (respLen != streamReadCmd->getRespBuffSize())  return;
+
+  memcpy(streamReadCmd->getRespBuf().data(), rcvBuf.data(), respLen);
+  streamReadCmd->setRespLen(respLen);
+
+  lastRespTime = chrono::system_clock::now();
+  lastStreamTime = chrono::steady_clock::now();
+
+  if (!streamActive)  {
+    log->info(" === "s + portName + ": Stream of RO values active ===\n\n");
+    streamActive = true;
+    setStateFlags(eStateFlags::AsyncConActive, true);
+  }
+
+  applyReadRegsResp(*streamReadCmd);
+
+  schedulePost();
+}
+
+//-----------------------------------------------------------------------------
+constexpr double RTTEstimator::InitialRTO;
+constexpr double RTTEstimator::MinRTO;
+constexpr double RTTEstimator::MaxRTO;
+constexpr double RTTEstimator::EraseMinRTO;
+
+//-----------------------------------------------------------------------------
+//  Update the smoothed RTT and the mean deviation (as in RFC 6298)
+//-----------------------------------------------------------------------------
+void RTTEstimator::addSample(double rtt)
+{
+  if (!numSamples++)  {
+    srtt = rtt;  rttVar = rtt / 2;  return; }
+
+  rttVar = 0.75 * rttVar + 0.25 * fabs(srtt - rtt);
+  srtt = 0.875 * srtt + 0.125 * rtt;
+}
+
+//-----------------------------------------------------------------------------
+//  Return the retransmit timeout, doubled for each attempt after the 1st one
+//-----------------------------------------------------------------------------
+double RTTEstimator::getRTO(int attempt) const
+{
+  double rto = numSamples ? (srtt + 4 * rttVar) : InitialRTO;
+
+  for (int u=1; u<attempt; ++u)  rto *= 2;
+
+  return min(max(rto, minRTO), MaxRTO);
+}
+
+//-----------------------------------------------------------------------------
+//  Return the RTT estimate for the type of cmd.  An erase takes much longer
+//  than a block read/write, so it gets its own estimate, with a floor that
+//  keeps its retry budget at least as long as the old fixed timeouts.
+//-----------------------------------------------------------------------------
+RTTEstimator & drvFGPDB::rttEstimator(LCPCmdBase &LCPCmd)
+{
+  switch (static_cast<LCPCommand>(LCPCmd.getCmdLCPCommand()))  {
+    case LCPCommand::ERASE_BLOCK:
+      return eraseRTTEst;
+    case LCPCommand::READ_BLOCK:
+    case LCPCommand::WRITE_BLOCK:
+      return blockRTTEst;
+    default:
+      return regRTTEst;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//  Update the RTT estimate using a cmd that got a response to its 1st send
+//-----------------------------------------------------------------------------
+void drvFGPDB::updateRTT(const InFlightCmd &cmd)
+{
+  chrono::duration<double> rtt = cmd.rcvTime - cmd.sendTime;
+
+  RTTEstimator &est = rttEstimator(*cmd.LCPCmd);
+  est.addSample(rtt.count());
+
+  if (&est == &regRTTEst)  {
+    regRTT = (uint32_t)(est.getSRTT() * 1e6);  drvValueChgd(idRegRTT); }
+  else if (&est == &blockRTTEst)  {
+    blockRTT = (uint32_t)(est.getSRTT() * 1e6);  drvValueChgd(idBlockRTT); }
+}
+
+//-----------------------------------------------------------------------------
+//  Update the writeAccess state based on the sessionID in a response
+//-----------------------------------------------------------------------------
+void drvFGPDB::updateWriteAccess(uint32_t respSessionID)
+{
+  bool prevWriteAccess = writeAccess;
+
+  writeAccess = (respSessionID == sessionID.get());
+  if (prevWriteAccess != writeAccess)  {
+    setStateFlags(eStateFlags::WriteAccess, writeAccess);
+    if (writeAccess)
+      log->info(" === "s + portName + ": Now has write access ===\n\n");
+    else
+      log->info(" *** "s + portName + ": Lost write access ***\n\n");
+  }
+}
+
+
+//----------------------------------------------------------------------------
+//  Update the read state of the scalar ParamInfo objects
+//----------------------------------------------------------------------------
+asynStatus drvFGPDB::updateScalarReadValues(ScanClass scanClass)
+{
+  if (!pollPlanValid())  buildPollPlan();
+
+  PollPlan &plan = pollPlans.at(static_cast<size_t>(scanClass));
+
+  // For LCP regs: Read the latest values from the controller (with the reads
+  // for all the groups in flight at the same time)
+  if (ShowRegReads())  {
+    for (auto &readCmd : plan.readCmds)
+      log->info(str(format(" === %s: readRegs(0x%.8X, %d) ===\n") % portName %
+                readCmd.getOffset() % readCmd.getCount()));
+  }
+
+  // The ctlr pushes the RO group values (1st cmds) while a stream is active
+  size_t firstCmd = streamActive ? plan.numROCmds : 0;
+
+  if (!exitDriver and (firstCmd < plan.cmds.size()))
+    sendCmdsGetResps(pAsynUserUDP, plan.cmds.data() + firstCmd,
+                     plan.cmds.size() - firstCmd);
+
+  // Apply the responses for all the groups and the driver-only values in a
+  // single pass with the asyn lock held
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  for (size_t u=firstCmd; u<plan.readCmds.size(); ++u)
+    if (plan.readCmds[u].respRcvd())  applyReadRegsResp(plan.readCmds[u]);
+
+  if (scanClass != ScanClass::Default)  return asynSuccess;
+
+  // For driver-only params: Read the latest value from the local variables
+  // flagged as changed (and the ones that can't be flagged)
+  syncPktsRcvd = rcvdPktCount;  latePktsRcvd = latePktCount;
+
+  uint64_t chgd = drvValuesChgd.exchange(0) & allDrvValueBits;
+
+  for (int paramID=0; chgd; ++paramID, chgd >>= 1)
+    if (chgd & 1)  refreshDrvValue(params.at(paramID));
+
+  for (int paramID : unflaggedDrvValueIDs)  refreshDrvValue(params.at(paramID));
+
+  return asynSuccess;
+}
+
+//----------------------------------------------------------------------------
+//  Update the read value of a driver-only param from its local variable.
+//  Caller must hold the asyn lock.
+//----------------------------------------------------------------------------
+void drvFGPDB::refreshDrvValue(ParamInfo &param)
+{
+  U32 newValue = *param.drvValue;
+
+  if ((newValue == param.ctlrValRead)
+    and (param.readState == ReadState::Current))  return;
+
+  param.ctlrValRead = newValue;
+  param.setReadPending();
+}
+
+//----------------------------------------------------------------------------
+//  Build the index of the driver-only params that have a local variable.  The
+//  ones with a paramID < MaxFlaggedDrvValues are refreshed only when flagged
+//  as changed (see drvValueChgd()), the rest every cycle.
+//----------------------------------------------------------------------------
+void drvFGPDB::buildDrvValueIndex()
+{
+  allDrvValueBits = 0;  unflaggedDrvValueIDs.clear();
+
+  for (int paramID=0; (unsigned int)paramID<params.size(); ++paramID)  {
+    const ParamInfo &param = params.at(paramID);
     if (!param.drvValue or !param.isScalarParam())  continue;
     if (LCPUtil::isLCPRegParam(param.getRegAddr()))  continue;
 
-    U32 newValue = *param.drvValue;
+    if (drvValueBit(paramID))  allDrvValueBits |= drvValueBit(paramID);
+    else  unflaggedDrvValueIDs.push_back(paramID);
+  }
+
+  drvValuesChgd = allDrvValueBits;  // post all of them the 1st time
+}
+
+//----------------------------------------------------------------------------
+//  Build the READ_REGS cmds used for each poll cycle of each scan class.
+//  Their buffers are allocated and their headers encoded only once.  The regs
+//  of a scan class in each group are split in to the ranges that skip large
+//  gaps and fit in one datagram.
+//----------------------------------------------------------------------------
+void drvFGPDB::buildPollPlan()
+{
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  regMapChgd = false;
+  pollPlanMTU = etherMTU;
+  U32 maxCount = maxReadRegsCount(pollPlanMTU);
+
+  vector<int>  classParamIDs;
 
-    if ((newValue == param.ctlrValRead)
-      and (param.readState == ReadState::Current))  continue;
+  for (size_t u=0; u<pollPlans.size(); ++u)  {
+    PollPlan &plan = pollPlans[u];
+    ScanClass scanClass = static_cast<ScanClass>(u);
 
-    param.ctlrValRead = newValue;
-    param.readState = ReadState::Pending;
+    plan.readCmds.clear();  plan.cmds.clear();  plan.numROCmds = 0;
+
+    for (uint groupID : { ProcGroup_LCP_RO, ProcGroup_LCP_WA, ProcGroup_LCP_WO })  {
+      const vector<int> &paramIDs = getProcGroup(groupID).paramIDs;
+
+      classParamIDs.assign(paramIDs.size(), -1);
+      for (size_t offset=0; offset<paramIDs.size(); ++offset)
+        if (validParamID(paramIDs[offset])
+            and (params.at(paramIDs[offset]).getScanClass() == scanClass))
+          classParamIDs[offset] = paramIDs[offset];
+
+      for (auto &range : planRegReads(classParamIDs, maxCount))
+        plan.readCmds.emplace_back((groupID << 16) | range.first, range.second, 0);
+      if (groupID == ProcGroup_LCP_RO)  plan.numROCmds = plan.readCmds.size();
+    }
+
+    for (auto &readCmd : plan.readCmds)  plan.cmds.push_back(&readCmd);
   }
+}
 
-  return asynSuccess;
+//----------------------------------------------------------------------------
+double drvFGPDB::scanPeriod(ScanClass scanClass)
+{
+  switch (scanClass)  {
+    case ScanClass::Hz10:     return 0.100;
+    case ScanClass::Hz1:      return 1.000;
+    case ScanClass::Hz0_1:    return 10.000;
+    case ScanClass::Default:  break;
+  }
+
+  return 0.200;
+}
+
+//----------------------------------------------------------------------------
+bool drvFGPDB::pollPlanValid()
+{
+  return !regMapChgd and (pollPlanMTU == etherMTU);
+}
+
+//----------------------------------------------------------------------------
+//  Find the cheapest set of ranges that covers all the defined regs.  The
+//  regs are 1st grouped in to runs of contiguous defined regs (split at
+//  maxCount), then cost[j] is the lowest cost for reading the 1st j runs,
+//  with the last range starting at run from[j].
+//----------------------------------------------------------------------------
+vector<pair<U32, U32>> drvFGPDB::planRegReads(const vector<int> &paramIDs,
+                                               U32 maxCount)
+{
+  vector<pair<U32, U32>>  runs, ranges;
+
+  if (!maxCount)  return ranges;
+
+  for (U32 offset=0; offset<paramIDs.size(); ++offset)  {
+    if (paramIDs[offset] < 0)  continue;
+    if (!runs.empty() and (runs.back().first + runs.back().second == offset)
+        and (runs.back().second < maxCount))
+      ++runs.back().second;
+    else
+      runs.emplace_back(offset, 1);
+  }
+
+  const U32 cmdCost = ReadRegsCmdPktSize + ReadRegsPktOverhead;
+  vector<U32>  cost(runs.size() + 1, 0);
+  vector<size_t>  from(runs.size() + 1, 0);
+
+  for (size_t j=1; j<=runs.size(); ++j)  {
+    U32 end = runs[j-1].first + runs[j-1].second;
+    cost[j] = numeric_limits<U32>::max();
+    for (size_t i=j; i>0; --i)  {
+      U32 count = end - runs[i-1].first;
+      if (count > maxCount)  break;
+      U32 rangeCost = cost[i-1] + cmdCost + count * 4;
+      if (rangeCost < cost[j])  { cost[j] = rangeCost;  from[j] = i-1; }
+    }
+  }
+
+  for (size_t j=runs.size(); j>0; j=from[j])  {
+    U32 first = runs[from[j]].first;
+    ranges.emplace_back(first, runs[j-1].first + runs[j-1].second - first);
+  }
+  reverse(ranges.begin(), ranges.end());
+
+  return ranges;
+}
+
+//----------------------------------------------------------------------------
+// Max # of register values that fit in one READ_REGS response datagram
+//----------------------------------------------------------------------------
+U32 drvFGPDB::maxReadRegsCount(U32 mtu)
+{
+  if (mtu < ReadRegsPktOverhead + 4)  return 0;
+
+  return (mtu - ReadRegsPktOverhead) / 4;
 }
 
 //----------------------------------------------------------------------------
@@ -1064,6 +2022,15 @@ asynStatus drvFGPDB::setAsynParamVal(int paramID)
                                    param.arrayValRead.size(), paramID, 0);
       break;
 
+    case asynParamInt32Array:
+    case asynParamFloat32Array:
+    case asynParamFloat64Array:
+      if (!param.isWaveformParam())  break;
+      setParamStatus(paramID, asynSuccess);  // req for doCallbacksXxxArray to work
+      param.convertWaveform();
+      stat = doWaveformCallbacks(param, param.wfValRead.size());
+      break;
+
     default:
       break;
   }
@@ -1096,31 +2063,71 @@ asynStatus drvFGPDB::readRegs(U32 firstReg, unsigned int numRegs)
 
   if (stat != asynSuccess)  return stat;
 
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  return applyReadRegsResp(readCmd);
+}
+
+//----------------------------------------------------------------------------
+// Update the read values of the params for the registers included in the
+// response to a READ_REGS cmd.  Caller must hold the asyn lock.
+//----------------------------------------------------------------------------
+asynStatus drvFGPDB::applyReadRegsResp(LCPReadRegs &readCmd)
+{
   //todo:  Check cmd-specific header values in returned packet
 
+  U32 firstReg = readCmd.getOffset();
+  unsigned int numRegs = readCmd.getCount();
+
+  if (!inDefinedRegRange(firstReg, numRegs))  return asynError;
+
   unsigned int groupID = LCPUtil::addrGroupID(firstReg);
   unsigned int offset = LCPUtil::addrOffset(firstReg);
 
   ProcGroup &group = getProcGroup(groupID);
+  group.resizeShadow();
+
+  const uint32_t *respVals = readCmd.getRespBuf().data()
+                           + readCmd.getRespHdrWords();
+  size_t numWords = (numRegs + 63) / 64;
+  chgdRegBits.resize(numWords);
+
+  // Only the regs that changed since their last accepted value (and the ones
+  // not read since the last reset) are passed on to their params
+  if (group.anyUnread(offset, numRegs))  {
+    fill(chgdRegBits.begin(), chgdRegBits.end(), ~uint64_t(0));
+    if (numRegs % 64)  chgdRegBits.back() = (uint64_t(1) << (numRegs % 64)) - 1;
+  }
+  else if (!LCPUtil::findChangedRegs(respVals, group.respShadow.data() + offset,
+                                     numRegs, chgdRegBits.data()))
+    return asynSuccess;
 
-  lock_guard<drvFGPDB> asynLock(*this);
+  auto now = chrono::steady_clock::now();
+  for (size_t w=0; w<numWords; ++w)  {
+    for (uint64_t bits = chgdRegBits[w]; bits; bits &= bits - 1)  {
+      size_t u = w * 64 + __builtin_ctzll(bits);
+      unsigned int regOffset = offset + u;
+      U32 justReadVal = ntohl(respVals[u]);
+      int paramID = group.paramIDs[regOffset];
 
-  std::vector<uint32_t>& respBuff = readCmd.getRespBuf();
-  int RespHdrWords = readCmd.getRespHdrWords();
-  for (unsigned int u=0; u<numRegs; ++u,++offset)  {
-    U32 justReadVal;
-    justReadVal = ntohl(respBuff.at(RespHdrWords +u));
-    int paramID = group.paramIDs.at(offset);
-    if (!validParamID(paramID))  continue;
+      if (!validParamID(paramID))  {
+        group.setRegRead(regOffset, respVals[u]);  continue; }
 
-    ParamInfo &param = params.at(paramID);
+      ParamInfo &param = params[paramID];
+
+      if ((justReadVal == param.ctlrValRead)
+        and (param.readState == ReadState::Current))  {
+        group.setRegRead(regOffset, respVals[u]);  continue; }
 
-    if ((justReadVal == param.ctlrValRead)
-      and (param.readState == ReadState::Current))  continue;
+      if (paramID == idUpSecs)  checkForRestart(justReadVal);
 
-    if (paramID == idUpSecs)  checkForRestart(justReadVal);
+      // deadbands and min interval from the param's definition (the shadow
+      // keeps the last accepted value, so a dropped one is checked again)
+      if (!param.passesReadingFilter(justReadVal, now))  continue;
 
-    param.newReadVal(justReadVal);
+      param.newReadVal(justReadVal);
+      group.setRegRead(regOffset, respVals[u]);
+    }
   }
 
   return asynSuccess;
@@ -1149,21 +2156,9 @@ asynStatus drvFGPDB::writeRegs(unsigned int firstReg, unsigned int numRegs)
 
   LCPWriteRegs writeCmd(firstReg, numRegs);
 
-  unsigned int groupID = LCPUtil::addrGroupID(firstReg);
-  unsigned int offset = LCPUtil::addrOffset(firstReg);
-
-  ProcGroup &group = getProcGroup(groupID);
-
-  uint16_t idx = writeCmd.getCmdHdrWords();
   {
     lock_guard<drvFGPDB> asynLock(*this);
-    for (unsigned int u=0; u<numRegs; ++u,++offset,++idx)  {
-      int paramID = group.paramIDs.at(offset);
-      if (!validParamID(paramID))  { return asynError; }
-      ParamInfo &param = params.at(paramID);
-      writeCmd.setCmdBufData(idx, param.ctlrValSet);
-      param.setState = SetState::Processing;
-    }
+    if (loadWriteRegsCmd(writeCmd) != asynSuccess)  return asynError;
   }
 
   stat = sendCmdGetResp(pAsynUserUDP, writeCmd, respStatus);
@@ -1186,22 +2181,170 @@ asynStatus drvFGPDB::writeRegs(unsigned int firstReg, unsigned int numRegs)
   //    SUCCESS does NOT necessarily mean that all the values written were
   //    accepted as-is)
 
-  offset = LCPUtil::addrOffset(firstReg);
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+    if (finishWriteRegsCmd(writeCmd, SetState::Sent))  callParamCallbacks();
+  }
+
+  writeAccessTimer.restart();  // reset timeout to avoid unnecessary callbacks
+
+  return asynSuccess;
+}
+
+//----------------------------------------------------------------------------
+// Copy the settings for the registers in a WRITE_REGS cmd to the cmd and flag
+// them as being processed.  Caller must hold the asyn lock.
+//----------------------------------------------------------------------------
+asynStatus drvFGPDB::loadWriteRegsCmd(LCPWriteRegs &writeCmd)
+{
+  U32 firstReg = writeCmd.getOffset();
+  unsigned int numRegs = writeCmd.getCount();
+
+  ProcGroup &group = getProcGroup(LCPUtil::addrGroupID(firstReg));
+  unsigned int offset = LCPUtil::addrOffset(firstReg);
+
+  if (offset + numRegs > group.setVals.size())  return asynError;
+
+  uint16_t idx = writeCmd.getCmdHdrWords();
+  for (unsigned int u=0; u<numRegs; ++u,++offset,++idx)  {
+    int paramID = group.paramIDs[offset];
+    if (!validParamID(paramID))  return asynError;
+    writeCmd.setCmdBufData(idx, group.setVals[offset]);
+    updateSetting(params.at(paramID), SetState::Processing);
+  }
+
+  return asynSuccess;
+}
+
+//----------------------------------------------------------------------------
+// Update the setState of the params for the registers in a WRITE_REGS cmd
+// once the cmd is done.  Settings that are no longer Processing were changed
+// by a client in the meantime and are left as they are.  Caller must hold
+// the asyn lock.
+//----------------------------------------------------------------------------
+bool drvFGPDB::finishWriteRegsCmd(LCPWriteRegs &writeCmd, SetState newState)
+{
+  bool  statusChgd = false;
+  asynStatus  prevStat;
+
+  U32 firstReg = writeCmd.getOffset();
+  unsigned int numRegs = writeCmd.getCount();
+
+  ProcGroup &group = getProcGroup(LCPUtil::addrGroupID(firstReg));
+  unsigned int offset = LCPUtil::addrOffset(firstReg);
+
+  for (unsigned int u=0; u<numRegs; ++u,++offset)  {
+    if (offset >= group.setStates.size())  break;
+    if (group.setStates[offset] != static_cast<uint8_t>(SetState::Processing))
+      continue;
+    int paramID = group.paramIDs[offset];
+    if (!validParamID(paramID))  continue;
+    updateSetting(params.at(paramID), newState);
+    if (newState == SetState::Error)  {
+      setParamStatus(paramID, asynError);  statusChgd = true; }
+    // clear the error from a setting the ctlr rejected earlier
+    else if ((newState == SetState::Sent) and
+             (getParamStatus(paramID, &prevStat) == asynSuccess) and
+             (prevStat == asynError))  {
+      setParamStatus(paramID, asynSuccess);  statusChgd = true; }
+  }
+
+  return statusChgd;
+}
+
+//----------------------------------------------------------------------------
+// Max # of register values that fit in one WRITE_REGS datagram
+//----------------------------------------------------------------------------
+U32 drvFGPDB::maxWriteRegsCount(U32 mtu)
+{
+  if (mtu < WriteRegsPktOverhead + 4)  return 0;
+
+  return (mtu - WriteRegsPktOverhead) / 4;
+}
+
+//----------------------------------------------------------------------------
+// Send all the pending settings for LCP registers.  The settings for each run
+// of contiguous registers in a group are merged in to one WRITE_REGS cmd, and
+// all the cmds are in flight at the same time.  Settings without a response
+// stay Pending (so they are sent again later).  Settings the ctlr rejected are
+// flagged as errors, and the asyn clients see an error status for them until
+// a new setting for the same reg is sent.
+//----------------------------------------------------------------------------
+asynStatus drvFGPDB::writePendingRegs(void)
+{
+  if (exitDriver)  return asynError;
+
+  U32 maxCount = maxWriteRegsCount(etherMTU);
+  if (!maxCount)  return asynError;
+
+  writeRegsCmds.clear();  writeCmds.clear();
+
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+
+    const uint8_t pending = static_cast<uint8_t>(SetState::Pending);
+
+    for (auto groupID : { ProcGroup_LCP_WA, ProcGroup_LCP_WO })  {
+      const ProcGroup &group = getProcGroup(groupID);
+      const vector<uint8_t> &setStates = group.setStates;
+
+      for (U32 offset=0;
+           (offset = group.findSetState(offset, SetState::Pending))
+             < setStates.size(); )  {
+        U32 first = offset;
+        while ((offset < setStates.size()) and (offset - first < maxCount) and
+               (setStates[offset] == pending))  ++offset;
+
+        writeRegsCmds.emplace_back((U32(groupID) << 16) | first, offset - first);
+        loadWriteRegsCmd(writeRegsCmds.back());
+      }
+    }
+  }
+
+  if (writeRegsCmds.empty())  return asynSuccess;
+
+  for (auto &writeCmd : writeRegsCmds)  {
+    if (ShowRegWrites())
+      log->info(str(format(" === %s: writeRegs(0x%.8X, %d) ===\n") % portName %
+                writeCmd.getOffset() % writeCmd.getCount()));
+    writeCmds.push_back(&writeCmd);
+  }
+
+  sendCmdsGetResps(pAsynUserUDP, writeCmds.data(), writeCmds.size());
 
-  lock_guard<drvFGPDB> asynLock(*this);
-  for (unsigned int u=0; u<numRegs; ++u,++offset)  {
-    int paramID = group.paramIDs.at(offset);
-    if (!validParamID(paramID))  continue;
-    ParamInfo &param = params.at(paramID);
-    // in case setState was chgd by another thread
-    if (param.setState == SetState::Processing)  {
-      param.setState = SetState::Sent;
+  bool  unsent = false, rejected = false, sent = false, statusChgd = false;
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+
+    for (auto &writeCmd : writeRegsCmds)  {
+      SetState newState = SetState::Sent;
+
+      if (!writeCmd.respRcvd())
+        newState = SetState::Pending;
+      else if (writeCmd.getRespStatus() == LCPStatus::ACCESS_DENIED)
+        newState = SetState::Pending;  // resent once write access is regained
+      else if (writeCmd.getRespStatus() != LCPStatus::SUCCESS)
+        newState = SetState::Error;
+
+      statusChgd |= finishWriteRegsCmd(writeCmd, newState);
+
+      unsent |= (newState == SetState::Pending);
+      rejected |= (newState == SetState::Error);
+      sent |= (newState == SetState::Sent);
     }
+
+    if (statusChgd)  callParamCallbacks();
   }
 
-  writeAccessTimer.restart();  // reset timeout to avoid unnecessary callbacks
+  if (rejected)
+    log->major(" *** "s + portName + ": ctlr rejected one or more settings ***\n");
 
-  return asynSuccess;
+  if (sent)  {
+    lastWriteTime = chrono::system_clock::now();
+    writeAccessTimer.restart();  // reset timeout to avoid unnecessary callbacks
+  }
+
+  return (unsent ? asynError : asynSuccess);
 }
 
 //----------------------------------------------------------------------------
@@ -1311,44 +2454,248 @@ bool drvFGPDB::isValidWritableParam(const char *funcName, asynUser *pasynUser)
 asynStatus drvFGPDB::applyNewParamSetting(ParamInfo &param, uint32_t setVal)
 {
   asynStatus stat = asynSuccess;
-  param.ctlrValSet = setVal;
 
+  SetState setState;
   if (initComplete or (resendMode == ResendMode::AfterIOCRestart))
-      param.setState = SetState::Pending;
+      setState = SetState::Pending;
   else if (resendMode == ResendMode::Never)
-      param.setState = SetState::Sent;
+      setState = SetState::Sent;
   else
-      param.setState = SetState::Restored;
-
-  if (!param.isScalarParam())  return asynError;;
+      setState = SetState::Restored;
 
-  SetState setState;
   {
     lock_guard<drvFGPDB> asynLock(*this);
-    setState = param.setState;
+    param.ctlrValSet = setVal;
+    updateSetting(param, setState);
   }
+
+  if (!param.isScalarParam())  return asynError;;
+
   if (setState != SetState::Pending)  return asynSuccess;
 
-  // LCP reg param: Write new setting to the controller
+  // LCP reg param: The new setting is sent to the controller by the
+  // eventTimer thread (see processScalarWrites())
   if (LCPUtil::isLCPRegParam(param.getRegAddr()))  {
     if (!connected or !writeAccess)  return asynError;
-    stat = writeRegs(param.getRegAddr(), 1);
+    // wait up to writeWindow ms so more settings can be merged in to the
+    // same WRITE_REGS cmds
+    scalarWritesTimer.start(writeWindow / 1000.0);
     if (param.drvValue)  {  // also update local var if one specified
         lock_guard<drvFGPDB> asynLock(*this);
         *param.drvValue = param.ctlrValSet;
+        drvValueChgd(ParamID(param));
     }
+    return asynSuccess;
   }
 
   // Driver-only params: Write new setting to local variable
   if (param.drvValue)  {
       lock_guard<drvFGPDB> asynLock(*this);
       *param.drvValue = param.ctlrValSet;
-      param.setState = SetState::Sent;
+      updateSetting(param, SetState::Sent);
+      drvValueChgd(ParamID(param));
   }
   return stat;
 }
 
 
+//-----------------------------------------------------------------------------
+//  Largest power-of-2 # of PMEM data bytes that fit in one datagram
+//-----------------------------------------------------------------------------
+U32 drvFGPDB::maxPmemPayload(U32 mtu)
+{
+  if (mtu < PmemPktOverhead + 4)  return 0;
+
+  U32 payload = 4;
+  while (payload * 2 + PmemPktOverhead <= mtu)  payload *= 2;
+
+  return payload;
+}
+
+//-----------------------------------------------------------------------------
+//  Split a PMEM block in to the fewest sub-blocks that fit in the etherMTU
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::splitBlock(U32 blockSize, U32 blockNum, U32 &useBlockSize,
+                                U32 &useBlockNum, unsigned int &subBlocks)
+{
+  U32 maxPayload = maxPmemPayload(etherMTU);
+  if (!maxPayload or !blockSize)  return asynError;
+
+  useBlockSize = min(blockSize, maxPayload);
+  subBlocks = blockSize / useBlockSize;
+  useBlockNum = blockNum * subBlocks;
+
+  if (useBlockSize * subBlocks != blockSize)  return asynError;
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+//  Look for the largest MTU (up to probeMTU) that works for PMEM transfers by
+//  reading increasingly smaller blocks from the ctlr, starting with the
+//  largest that fits in probeMTU.  etherMTU is only ever increased, so the
+//  configured value should be one that is known to work.
+//
+//  A block that doesn't fit is simply dropped by the network, so each size
+//  is only sent once (with a short timeout instead of the usual retries),
+//  and the sizes that failed are not tried again after a reconnect (unless
+//  probeMTU is changed).
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::probeEtherMTU(void)
+{
+  if (probeMTU != probeFailedMTU)  {
+    probeFailedMTU = probeMTU;  probeFailedPayload = 0; }
+
+  for (U32 payload = maxPmemPayload(probeMTU);
+       payload > maxPmemPayload(etherMTU);  payload /= 2)  {
+    if (probeFailedPayload and (payload >= probeFailedPayload))  continue;
+
+    LCPReadBlock  probeCmd(0, payload, 0);
+    LCPCmdBase * const probeCmds[] = { &probeCmd };
+
+    if ((sendCmdsGetResps(pAsynUserUDP, probeCmds, 1, 1, MTUProbeTimeout)
+         != asynSuccess) or (probeCmd.getRespStatus() != LCPStatus::SUCCESS))  {
+      probeFailedPayload = payload;  continue; }
+
+    {
+      lock_guard<drvFGPDB> asynLock(*this);
+      etherMTU = payload + PmemPktOverhead;  drvValueChgd(idEtherMTU);
+    }
+    log->info(" === "s + portName + ": Using an MTU of " +
+              to_string(payload + PmemPktOverhead) + " bytes ===\n\n");
+    return asynSuccess;
+  }
+
+  return asynError;
+}
+
+//-----------------------------------------------------------------------------
+//  Max # of waveform values that fit in one datagram
+//-----------------------------------------------------------------------------
+U32 drvFGPDB::maxWaveformCount(U32 mtu)
+{
+  if (mtu < WaveformPktOverhead + 4)  return 0;
+
+  return (mtu - WaveformPktOverhead) / 4;
+}
+
+//-----------------------------------------------------------------------------
+//  Read all the values of a ctlr waveform.  The READ_WAVEFORM cmds (one for
+//  each chunk that fits in a datagram) are reused from the previous read as
+//  long as the etherMTU doesn't change, and the values are decoded straight
+//  in to the param's preallocated buffer.
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::readWaveform(ParamInfo &param)
+{
+  asynStatus  stat;
+  U32  waveformID = param.getWaveformID();
+  U32  length = param.getWaveformLength();
+
+  if (param.wfValRead.size() != length)  return asynError;
+
+  U32  chunkSize = maxWaveformCount(etherMTU);
+  if (!chunkSize)  return asynError;
+
+  unsigned int numCmds = (length + chunkSize - 1) / chunkSize;
+
+  if (ShowWaveReads())  {
+    log->info(str(format(" === %s: readWaveform(%s, ID %d, %d values in %d "
+              "cmds) ===\n") % portName % param.name % waveformID % length %
+              numCmds));
+  }
+
+  if (!wfReadCmds.empty() and
+      (wfReadCmds.front().getRespBuf().size() !=
+       wfReadCmds.front().getRespHdrWords() + chunkSize))  wfReadCmds.clear();
+
+  if (wfReadCmds.size() < numCmds)  wfReadCmds.reserve(numCmds);
+  while (wfReadCmds.size() < numCmds)  wfReadCmds.emplace_back(0, 0, chunkSize, 0);
+
+  wfCmds.clear();
+  for (unsigned int u=0; u<numCmds; ++u)  {
+    U32 offset = u * chunkSize;
+    wfReadCmds[u].setRange(waveformID, offset, min(chunkSize, length - offset));
+    wfCmds.push_back(&wfReadCmds[u]);
+  }
+
+  stat = sendCmdsGetResps(pAsynUserUDP, wfCmds.data(), wfCmds.size());
+
+  if (stat != asynSuccess)  return stat;
+
+  // a short response would leave the values from the last read in the tail
+  // of the chunk
+  for (unsigned int u=0; u<numCmds; ++u)  {
+    LCPReadWF &readCmd = wfReadCmds[u];
+    if (readCmd.getRespStatus() != LCPStatus::SUCCESS)  return asynError;
+    if (readCmd.getRespLen() < (readCmd.getRespHdrWords() + readCmd.getCount())
+                               * sizeof(uint32_t))  {
+      log->major(" *** "s + portName + ":" + param.name + ": short " +
+                 "READ_WAVEFORM response (" + to_string(readCmd.getRespLen()) +
+                 " bytes) ***\n\n");
+      return asynError;
+    }
+  }
+
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  U32 *vals = param.wfValRead.data();
+
+  for (unsigned int u=0; u<numCmds; ++u)  {
+    LCPReadWF &readCmd = wfReadCmds[u];
+    const uint32_t *respVals = readCmd.getRespBuf().data() + readCmd.getRespHdrWords();
+    U32 count = readCmd.getCount();
+    for (U32 v=0; v<count; ++v)  *vals++ = ntohl(respVals[v]);
+  }
+
+  param.setReadPending();
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::doWaveformCallbacks(ParamInfo &param, size_t numVals)
+{
+  int paramID = ParamID(param);
+
+  switch (param.getAsynType())  {
+    case asynParamInt32Array:
+      return doCallbacksInt32Array(param.wfInt32.data(),
+                                   min(numVals, param.wfInt32.size()), paramID, 0);
+    case asynParamFloat32Array:
+      return doCallbacksFloat32Array(param.wfFloat32.data(),
+                                     min(numVals, param.wfFloat32.size()), paramID, 0);
+    case asynParamFloat64Array:
+      return doCallbacksFloat64Array(param.wfFloat64.data(),
+                                     min(numVals, param.wfFloat64.size()), paramID, 0);
+    default:
+      return asynError;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//  Get the PMEM block cmds ready for a transfer.  The cmds from the previous
+//  transfer are reused (only the chip and block numbers are updated) as long
+//  as the block size is the same, so a multi-block transfer of an image does
+//  not allocate any buffers after the first block.
+//-----------------------------------------------------------------------------
+template <class BlockCmd>
+void drvFGPDB::prepBlockCmds(vector<BlockCmd> &cmds, vector<LCPCmdBase *> &LCPCmds,
+                             unsigned int chipNum, U32 blockSize,
+                             U32 firstBlockNum, unsigned int numCmds)
+{
+  if (!cmds.empty() and (cmds.front().getBlockSize() != blockSize))
+    cmds.clear();
+
+  if (cmds.size() < numCmds)  cmds.reserve(numCmds);
+  while (cmds.size() < numCmds)  cmds.emplace_back(chipNum, blockSize, 0);
+
+  LCPCmds.clear();
+  for (unsigned int u=0; u<numCmds; ++u)  {
+    cmds[u].setChipNum(chipNum);  cmds[u].setBlockNum(firstBlockNum + u);
+    LCPCmds.push_back(&cmds[u]);
+  }
+}
+
 //-----------------------------------------------------------------------------
 //  Erase a block of data in Flash or one of the EEPROMs on the controller
 //
@@ -1393,9 +2740,8 @@ asynStatus drvFGPDB::readBlock(unsigned int chipNum, U32 blockSize, U32 blockNum
                                vector<uint8_t> &buf)
 {
   asynStatus  stat;
-  LCPStatus  respStatus;
   unsigned int subBlocks;
-  U32  useBlockSize, useBlockNum, etherMTU;
+  U32  useBlockSize, useBlockNum;
   uint8_t *blockData;
 
 
@@ -1407,37 +2753,33 @@ asynStatus drvFGPDB::readBlock(unsigned int chipNum, U32 blockSize, U32 blockNum
 
   if (blockSize > buf.size())  return asynError;
 
-  etherMTU = 1500;  //ToDo:  How to determine the ACTUAL MTU?
-
   // Split the read of the requested blockSize # of bytes in to multiple read
   // requests if necessary to fit in the ethernet MTU size ---
-  useBlockSize = blockSize;  useBlockNum = blockNum;  subBlocks = 1;
-  while (useBlockSize + 30 > etherMTU) {
-    useBlockSize /= 2;  useBlockNum *= 2;  subBlocks *= 2; }
-
-  if (useBlockSize * subBlocks != blockSize)  return asynError;
+  if (splitBlock(blockSize, blockNum, useBlockSize, useBlockNum, subBlocks)
+      != asynSuccess)  return asynError;
 
-  // Read the sub-blocks in reverse order, "back-filling" blockDataBuf so we
-  // end up with a full blockSize # of contiguous bytes when done (each read
-  // after the 1st overwriting the header rcvd for the prev read)
+  // Send the reads for all the sub-blocks (several of them in flight at the
+  // same time) and then copy the data from each response to its place in the
+  // buffer so we end up with a full blockSize # of contiguous bytes
 
   blockData = buf.data();
 
-  LCPReadBlock readBlockCmd(chipNum, useBlockSize, useBlockNum);
+  prepBlockCmds(readBlockCmds, blockCmds, chipNum, useBlockSize, useBlockNum,
+                subBlocks);
 
-  while (subBlocks)  {
+  stat = sendCmdsGetResps(pAsynUserUDP, blockCmds.data(), blockCmds.size());
 
-    stat = sendCmdGetResp(pAsynUserUDP, readBlockCmd, respStatus);
-
-    if (stat != asynSuccess)  return stat;
+  if (stat != asynSuccess)  return stat;
 
-    //todo:  Check cmd-specific header values in returned packet
-    //       (the respStatus in particular!)
+  //todo:  Check cmd-specific header values in returned packet
+  //       (the respStatus in particular!)
 
+  for (unsigned int u=0; u<subBlocks; ++u)  {
+    LCPReadBlock &readBlockCmd = readBlockCmds.at(u);
+    if (readBlockCmd.getRespLen() < readBlockCmd.getRespBuffSize())
+      return asynError;  // short response
     memcpy(blockData, readBlockCmd.getRespBuf().data() + readBlockCmd.getRespHdrWords(), useBlockSize);
-
-    blockData += useBlockSize;  ++useBlockNum;  --subBlocks;
-    readBlockCmd.setBlockNum(useBlockNum); // Update cmdBuf with new useBlockNum value
+    blockData += useBlockSize;
   }
 
   return asynSuccess;
@@ -1455,9 +2797,8 @@ asynStatus drvFGPDB::writeBlock(unsigned int chipNum, U32 blockSize,
                                 U32 blockNum, vector<uint8_t> &buf)
 {
   asynStatus  stat = asynError;
-  LCPStatus  respStatus;
   unsigned int subBlocks;
-  U32  useBlockSize, useBlockNum, etherMTU;
+  U32  useBlockSize, useBlockNum;
   uint8_t  *blockData;
 
   if (ShowBlkWrites())  {
@@ -1468,42 +2809,170 @@ asynStatus drvFGPDB::writeBlock(unsigned int chipNum, U32 blockSize,
 
   if (buf.size() < blockSize)  return asynError;
 
-  etherMTU = 1500;  //ToDo:  How to determine the ACTUAL MTU?
-
-  // Split the read of the requested blockSize # of bytes in to multiple
+  // Split the write of the requested blockSize # of bytes in to multiple
   // write requests if necessary to fit in the ethernet MTU size ---
-  useBlockSize = blockSize;  useBlockNum = blockNum;  subBlocks = 1;
-  while (useBlockSize + 30 > etherMTU) {
-    useBlockSize /= 2;  useBlockNum *= 2;  subBlocks *= 2; }
-
-  if (useBlockSize * subBlocks != blockSize)  return asynError;
+  if (splitBlock(blockSize, blockNum, useBlockSize, useBlockNum, subBlocks)
+      != asynSuccess)  return asynError;
 
   blockData = buf.data();
 
-  LCPWriteBlock writeBlockCmd(chipNum, useBlockSize, useBlockNum);
-
-  while (subBlocks)  {
+  prepBlockCmds(writeBlockCmds, blockCmds, chipNum, useBlockSize, useBlockNum,
+                subBlocks);
 
+  for (unsigned int u=0; u<subBlocks; ++u)  {
+    LCPWriteBlock &writeBlockCmd = writeBlockCmds.at(u);
     memcpy(writeBlockCmd.getCmdBuf().data() + writeBlockCmd.getCmdHdrWords(), blockData, useBlockSize);
+    blockData += useBlockSize;
+  }
+
+  // several sub-blocks in flight at the same time
+  stat = sendCmdsGetResps(pAsynUserUDP, blockCmds.data(), blockCmds.size());
+
+  if (stat != asynSuccess)  return stat;
 
-    stat = sendCmdGetResp(pAsynUserUDP, writeBlockCmd, respStatus);
+  //todo:  Check cmd-specific header values in returned packet
+  //       (the respStatus in particular!)
 
-    if (stat != asynSuccess)  return stat;
+  writeAccessTimer.restart();  // reset timeout to avoid unnecessary callbacks
 
-    //todo:  Check cmd-specific header values in returned packet
-    //       (the respStatus in particular!)
+  return asynSuccess;
+}
 
-    blockData += useBlockSize;  ++useBlockNum;  --subBlocks;
-    writeBlockCmd.setBlockNum(useBlockNum); // Update cmdBuf with new useBlockNum value
+//-----------------------------------------------------------------------------
+//  Get a param ready for a streaming read of its array value.  The sub-blocks
+//  are the largest power-of-2 # of bytes that fit in the etherMTU (and in the
+//  param's blockSize), and are numbered relative to that size.  All of the
+//  1st and last blocks are read (not just the bytes in the array), so the
+//  block cache has what a read-modify-write of those blocks needs.
+//-----------------------------------------------------------------------------
+asynStatus drvFGPDB::initReadStream(ParamInfo &param)
+{
+  U32 maxPayload = maxPmemPayload(etherMTU);
+  U32 blockSize = param.getBlockSize();
+  if (!maxPayload or !blockSize or param.arrayValRead.empty())  return asynError;
+
+  U32 subBlockSize = min(blockSize, maxPayload);
+  if (blockSize % subBlockSize)  return asynError;
+
+  uint64_t firstByte = param.getOffset();
+  uint64_t endByte = firstByte + param.arrayValRead.size();
+  uint64_t firstBlock = firstByte / blockSize,
+           endBlock = (endByte - 1) / blockSize + 1;
+  uint32_t subsPerBlock = blockSize / subBlockSize;
+  uint32_t firstSubBlock = firstBlock * subsPerBlock,
+           lastSubBlock = endBlock * subsPerBlock - 1;
+
+  size_t numBlocks = endBlock - firstBlock;
+
+  if (param.blockValid.size() != numBlocks)
+    param.blockValid.assign(numBlocks, false);
+  param.blockSubsLeft.assign(numBlocks, subsPerBlock);
+  param.headBytes.resize(firstByte - firstBlock * blockSize);
+  param.tailBytes.resize(endBlock * blockSize - endByte);
+
+  // blocks not read to verify a write keep their cached copy (and already
+  // hold the bytes written)
+  param.unreadSubBlocks.clear();
+  param.unreadSubBlocks.reserve(lastSubBlock - firstSubBlock + 1);
+  for (size_t idx = numBlocks; idx-- > 0; )  {
+    uint64_t blockStart = (firstBlock + idx) * blockSize;
+    if (!param.verifyBlock(idx))  {
+      param.reduceBytesLeftBy(min(blockStart + blockSize, endByte)
+                              - max(blockStart, firstByte));
+      continue;
+    }
+    param.blockValid[idx] = false;
+    uint32_t firstSub = blockStart / subBlockSize;
+    for (uint32_t n = firstSub + subsPerBlock; n-- > firstSub; )
+      param.unreadSubBlocks.push_back(n);
   }
 
-  writeAccessTimer.restart();  // reset timeout to avoid unnecessary callbacks
+  param.subBlockSize = subBlockSize;
+  param.streamBytes = param.getBytesLeft();
+  param.readStartTime = chrono::steady_clock::now();
+
+  param.readRate = 0;
+  if (param.rdRateParamID >= 0)  params.at(param.rdRateParamID).newReadVal(0);
 
   return asynSuccess;
 }
 
 //-----------------------------------------------------------------------------
-//  Read next block of a PMEM array value from the controller
+//  The cache files are keyed by the ctlr and the array's PMEM region, so a
+//  file is only reused for the same region of the same ctlr
+//-----------------------------------------------------------------------------
+void drvFGPDB::openPmemCaches(void)
+{
+  if (pmemCacheDir.empty())  return;
+
+  for (int paramID=0; (unsigned int)paramID<params.size(); ++paramID) {
+    const ParamInfo &param = params.at(paramID);
+    if (!param.isArrayParam() or pmemCaches.count(paramID))  continue;
+
+    auto cache = make_unique<PmemCache>(ctlrAddr, param.getChipNum(),
+                                        param.getOffset(),
+                                        param.arrayValRead.size(),
+                                        param.getBlockSize());
+    if (cache->open(pmemCacheDir) != asynSuccess)  {
+      log->major(" *** "s + portName + ":" + param.name + ": Unable to " +
+                 "open PMEM cache file: " + cache->getPath() + " ***\n\n");
+      continue;
+    }
+    pmemCaches.emplace(paramID, move(cache));
+  }
+}
+
+//-----------------------------------------------------------------------------
+//  A cache file only loads if the hashes of its blocks are intact, and it is
+//  invalidated when this driver writes to the region (writeInt8Array()) or
+//  sees the ctlr restart (checkForRestart()).  A cached image that loads is
+//  therefore the ctlr's value and is posted instead of streaming the region
+//  again.  Writes to the region by other clients of the ctlr can't be seen,
+//  so no cache dir should be set if there are any.
+//-----------------------------------------------------------------------------
+void drvFGPDB::publishCachedArrays(void)
+{
+  for (auto &entry : pmemCaches)  {
+    int paramID = entry.first;
+    ParamInfo &param = params.at(paramID);
+
+    if ((param.readState != ReadState::Update) or param.subBlockSize or
+        param.activePMEMwrite())  continue;
+
+    if (!entry.second->load(param.arrayValRead))  continue;
+
+    param.initBlockRW(param.arrayValRead.size());
+    param.reduceBytesLeftBy(param.getBytesLeft());  // nothing left to read
+    activeArrayReads.erase(paramID);
+    setArrayOperStatus(param);
+    param.setReadPending();
+    schedulePost();
+
+    if (ShowBlkReads())
+      log->info(" === "s + portName + ":" + param.name + ": using cached " +
+                "value from " + entry.second->getPath() + " ===\n");
+  }
+}
+
+//-----------------------------------------------------------------------------
+void drvFGPDB::updateReadRate(ParamInfo &param)
+{
+  chrono::duration<double> elapsed = chrono::steady_clock::now()
+                                   - param.readStartTime;
+  if (elapsed.count() <= 0.0)  return;
+
+  double bytesRead = param.streamBytes - param.getBytesLeft();
+  param.readRate = static_cast<uint32_t>(bytesRead / elapsed.count() / 1000.0);
+  if (param.rdRateParamID >= 0)
+    params.at(param.rdRateParamID).newReadVal(param.readRate);
+}
+
+//-----------------------------------------------------------------------------
+//  Read the next burst of sub-blocks of a PMEM array value from the
+//  controller.  The READ_BLOCK cmds for a burst are all sent at once (up to
+//  maxPktsInFlight of them in flight at the same time) and the data in each
+//  response is copied straight to its place in arrayValRead.  Sub-blocks
+//  without a good response are requested again in a later burst.
 //-----------------------------------------------------------------------------
 asynStatus drvFGPDB::readNextBlock(ParamInfo &param)
 {
@@ -1516,41 +2985,131 @@ asynStatus drvFGPDB::readNextBlock(ParamInfo &param)
   if ((setState == SetState::Pending) or (setState == SetState::Processing)
     or !connected)  return asynSuccess;
 
-  if (!param.getBytesLeft())  {
+  U32  subBlockSize;
+  unsigned int  chipNum;
+  {
     lock_guard<drvFGPDB> asynLock(*this);
-    param.readState = ReadState::Pending;
-    postNewReadingsTimer.wakeUp();
-    return asynSuccess;
+
+    if (!param.subBlockSize and param.getBytesLeft() and
+        (initReadStream(param) != asynSuccess))  return asynError;
+
+    if (!param.getBytesLeft() and param.unreadSubBlocks.empty())  {
+      // a write is verified if the blocks read back match the bytes
+      // written, otherwise all of the array is read back
+      if (param.verifyingWrite() and !param.verifiedBlocksMatch())  {
+        log->major(" *** "s + portName + ":" + param.name + ": the blocks " +
+                   "read back don't match the bytes written, reading back " +
+                   "all of the array ***\n\n");
+        param.initBlockRW(param.arrayValRead.size());
+        arrayReadsInProgress = true;
+        return asynSuccess;
+      }
+      if (param.subBlockSize and ShowBlkReads())  {
+        chrono::duration<double> elapsed = chrono::steady_clock::now()
+                                         - param.readStartTime;
+        log->info(str(format(" === %s:%s: read %u bytes in %.3f secs "
+                             "(%.2f MB/s) ===\n") % portName % param.name %
+                      param.streamBytes % elapsed.count() %
+                      (param.readRate / 1000.0)));
+      }
+      param.subBlockSize = 0;
+      auto cache = pmemCaches.find(ParamID(param));
+      if (cache != pmemCaches.end())  cache->second->store(param.arrayValRead);
+      param.setReadPending();
+      activeArrayReads.erase(ParamID(param));
+      schedulePost();
+      return asynSuccess;
+    }
+
+    if (param.unreadSubBlocks.empty())  return asynError;
+
+    subBlockSize = param.subBlockSize;  chipNum = param.getChipNum();
+
+    size_t numCmds = min<size_t>(param.unreadSubBlocks.size(),
+                                 max<U32>(PmemReadBurstBytes / subBlockSize, 1));
+    burstSubBlocks.assign(param.unreadSubBlocks.end() - numCmds,
+                          param.unreadSubBlocks.end());
+    param.unreadSubBlocks.resize(param.unreadSubBlocks.size() - numCmds);
   }
 
   arrayReadsInProgress = true;
 
-//--- initialize values used in the loop ---
-  param.rwBuf.assign(param.getBlockSize(), 0);
+  size_t numCmds = burstSubBlocks.size();
 
-  // adjust # of bytes to read from the next block if necessary
-  if (param.getRWCount() > param.getBytesLeft())  param.setRWCount(param.getBytesLeft());
+  if (ShowBlkReads())
+    log->info(str(format(" === %s: readBlocks(%d,%d,%d..%d) ===\n") % portName %
+                  chipNum % subBlockSize % burstSubBlocks.back() %
+                  burstSubBlocks.front()));
 
-  // read the next block of bytes
-  if (readBlock(param.getChipNum(), param.getBlockSize(), param.getBlockNum(), param.rwBuf))  {
-	log->major(" *** "s + portName + ": Error reading block " +
-               to_string(param.getBlockNum()) + " ***\n\n");
-    return asynError;
-  }
+  prepBlockCmds(readBlockCmds, blockCmds, chipNum, subBlockSize, 0, numCmds);
+  for (size_t u=0; u<numCmds; ++u)
+    readBlockCmds[u].setBlockNum(burstSubBlocks[numCmds - 1 - u]);
+
+  // The cmds without a response are simply requested again, so an error
+  // here only matters if nothing at all was read
+  sendCmdsGetResps(pAsynUserUDP, blockCmds.data(), blockCmds.size());
 
   lock_guard<drvFGPDB> asynLock(*this);
 
-  // Copy just read data to the appropriate bytes in the buffer
-  memcpy(param.arrayValRead.data() + param.getRWOffset(),
-         param.rwBuf.data() + param.getDataOffset(),
-         param.getRWCount());
+  if (param.subBlockSize != subBlockSize)  return asynSuccess;  // restarted
+
+  uint64_t firstByte = param.getOffset();
+  uint64_t endByte = firstByte + param.arrayValRead.size();
+  uint64_t headStart = firstByte - param.headBytes.size();
+  uint64_t firstBlock = firstByte / param.getBlockSize();
+  size_t numRead = 0;
+
+  // in reverse order, so the unread ones are put back in the same order
+  for (size_t u=numCmds; u-- > 0; )  {
+    LCPReadBlock &readBlockCmd = readBlockCmds[u];
+    uint32_t subBlockNum = burstSubBlocks[numCmds - 1 - u];
+
+    if (!readBlockCmd.respRcvd() or
+        (readBlockCmd.getRespStatus() != LCPStatus::SUCCESS) or
+        (readBlockCmd.getRespLen() < readBlockCmd.getRespBuffSize()))  {
+      param.unreadSubBlocks.push_back(subBlockNum);  continue; }
+
+    uint64_t subBlockStart = uint64_t(subBlockNum) * subBlockSize;
+    uint64_t subBlockEnd = subBlockStart + subBlockSize;
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(
+        readBlockCmd.getRespBuf().data() + readBlockCmd.getRespHdrWords());
+
+    // bytes before, in, and after the array
+    if (subBlockStart < firstByte)  {
+      uint64_t copyTo = min(subBlockEnd, firstByte);
+      memcpy(param.headBytes.data() + (subBlockStart - headStart), data,
+             copyTo - subBlockStart);
+    }
+    uint64_t copyFrom = max(subBlockStart, firstByte);
+    uint64_t copyTo = min(subBlockEnd, endByte);
+    if (copyFrom < copyTo)  {
+      memcpy(param.arrayValRead.data() + (copyFrom - firstByte),
+             data + (copyFrom - subBlockStart), copyTo - copyFrom);
+      param.reduceBytesLeftBy(copyTo - copyFrom);
+    }
+    if (subBlockEnd > endByte)  {
+      copyFrom = max(subBlockStart, endByte);
+      memcpy(param.tailBytes.data() + (copyFrom - endByte),
+             data + (copyFrom - subBlockStart), subBlockEnd - copyFrom);
+    }
+
+    // the cached copy of a block is good once all of it was read
+    size_t idx = subBlockStart / param.getBlockSize() - firstBlock;
+    if (!--param.blockSubsLeft.at(idx))  param.blockValid.at(idx) = true;
 
-  param.incrementBlockNum();  param.setDataOffset(0);  param.reduceBytesLeftBy(param.getRWCount());
-  param.setRWOffset(param.getRWOffset() + param.getRWCount());
-  param.setRWCount(param.getBlockSize());
+    ++numRead;
+  }
 
+  updateReadRate(param);
   setArrayOperStatus(param);  // update the status param
 
+  if (!numRead)  {
+    log->major(" *** "s + portName + ":" + param.name + ": Error reading " +
+               "sub-blocks " + to_string(burstSubBlocks.back()) + " to " +
+               to_string(burstSubBlocks.front()) + " ***\n\n");
+    return asynError;
+  }
+
   return asynSuccess;
 }
 
@@ -1559,14 +3118,32 @@ asynStatus drvFGPDB::readNextBlock(ParamInfo &param)
 //-----------------------------------------------------------------------------
 asynStatus drvFGPDB::writeNextBlock(ParamInfo &param)
 {
+  bool done;
   {
     lock_guard<drvFGPDB> asynLock(*this);
 
-    if (!param.getBytesLeft())  {
-      param.setState = SetState::Sent;
-      initArrayReadback(param);  // readback what we just finished sending
-      return asynSuccess;
+    // skip the blocks the new value does not change
+    bool skipped = false;
+    while (param.getBytesLeft() and !param.blockChgd())  {
+      param.advanceBlock();  skipped = true; }
+    if (skipped)  setArrayOperStatus(param);
+
+    done = !param.getBytesLeft();
+    if (done)  {
+      updateSetting(param, SetState::Sent);
+      activeArrayWrites.erase(ParamID(param));
     }
+  }
+
+  // check what we just finished sending (without the lock, the ctlr is
+  // asked for the CRC of each block written)
+  if (done)  {
+    verifyArrayWrite(param);
+    return asynSuccess;
+  }
+
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
 
     if (!writeAccess)  return asynError;
 
@@ -1575,7 +3152,7 @@ asynStatus drvFGPDB::writeNextBlock(ParamInfo &param)
     arrayWritesInProgress = true;
 
     // stops writeXxxArray() funcs from making concurrent changes
-    param.setState = SetState::Processing;
+    updateSetting(param, SetState::Processing);
   }
 
   // initialize values used in the loop
@@ -1584,14 +3161,28 @@ asynStatus drvFGPDB::writeNextBlock(ParamInfo &param)
   // adjust # of bytes to write to the next block if necessary
   if (param.getRWCount() > param.getBytesLeft())  param.setRWCount(param.getBytesLeft());
 
-  // If not replacing all the bytes in the block, then read the existing
-  // contents of the block to be modified.
-  if (param.getRWCount() != param.getBlockSize())
-    if (readBlock(param.getChipNum(), param.getBlockSize(), param.getBlockNum(), param.rwBuf))  {
+  // If not replacing all the bytes in the block, then get the existing
+  // contents of the block to be modified (from the block cache if it is
+  // current, otherwise from the ctlr)
+  if (param.getRWCount() != param.getBlockSize())  {
+    bool cached;
+    {
+      lock_guard<drvFGPDB> asynLock(*this);
+      cached = param.getCachedBlock(param.rwBuf);
+    }
+    if (!cached and readBlock(param.getChipNum(), param.getBlockSize(),
+                              param.getBlockNum(), param.rwBuf))  {
       log->major(" *** "s + ":[" + __func__ + "] Error reading block " +
                  to_string(param.getBlockNum()) + " ***\n\n");
       return asynError;
     }
+  }
+
+  // the cached copy is stale from now on (until the readback)
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+    param.invalidateBlock();
+  }
 
   // If required, 1st erase the next block to be written to
   if (param.getEraseReq())
@@ -1613,20 +3204,93 @@ asynStatus drvFGPDB::writeNextBlock(ParamInfo &param)
     return asynError;
   }
 
-  param.incrementBlockNum();  param.setDataOffset(0);  param.reduceBytesLeftBy(param.getRWCount());
-  param.setRWOffset(param.getRWOffset() + param.getRWCount());
-  param.setRWCount(param.getBlockSize());
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+    param.writtenCRCs.emplace_back(param.getBlockNum(),
+                                   LCPUtil::crc32c(param.rwBuf.data(),
+                                                   param.rwBuf.size()));
+  }
+
+  param.advanceBlock();
 
   setArrayOperStatus(param);  // update the status param
 
   return asynSuccess;
 }
 
+//-----------------------------------------------------------------------------
+//  Verify the write that just finished by asking the ctlr for the CRC-32C of
+//  each block written and comparing it with the CRC of the bytes sent.  If
+//  they all match, the value written is the new read value and nothing is
+//  read back.  Without a good CHECKSUM_BLOCK response (e.g. from a ctlr
+//  that doesn't have the cmd), only the blocks written are read back.
+//-----------------------------------------------------------------------------
+void drvFGPDB::verifyArrayWrite(ParamInfo &param)
+{
+  if (pmemFullReadback)  { initArrayReadback(param);  return; }
+
+  vector<pair<uint32_t, uint32_t>> writtenCRCs;
+  unsigned int  chipNum;
+  U32  blockSize;
+  {
+    lock_guard<drvFGPDB> asynLock(*this);
+    writtenCRCs = param.writtenCRCs;
+    chipNum = param.getChipNum();  blockSize = param.getBlockSize();
+  }
+
+  size_t numCmds = writtenCRCs.size();
+  prepBlockCmds(checksumBlockCmds, blockCmds, chipNum, blockSize, 0, numCmds);
+  for (size_t u=0; u<numCmds; ++u)
+    checksumBlockCmds[u].setBlockNum(writtenCRCs[u].first);
+
+  if (numCmds)  sendCmdsGetResps(pAsynUserUDP, blockCmds.data(), numCmds);
+
+  bool crcsRcvd = true, crcsMatch = true;
+  for (size_t u=0; u<numCmds; ++u)  {
+    LCPChecksumBlock &checksumCmd = checksumBlockCmds[u];
+    if (!checksumCmd.respRcvd() or
+        (checksumCmd.getRespStatus() != LCPStatus::SUCCESS))  {
+      crcsRcvd = false;  break; }
+    if (checksumCmd.getRespChecksum() != writtenCRCs[u].second)  {
+      log->major(str(format(" *** %s:%s: CRC of block %u is 0x%08X, not "
+                            "0x%08X as written, reading back all of the "
+                            "array ***\n\n") % portName % param.name %
+                     writtenCRCs[u].first % checksumCmd.getRespChecksum() %
+                     writtenCRCs[u].second));
+      crcsMatch = false;  break;
+    }
+  }
+
+  if (!crcsRcvd)  { initArrayReadback(param, true);  return; }
+  if (!crcsMatch)  { initArrayReadback(param);  return; }
+
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  if (param.setState != SetState::Sent)  return;  // a new value to write
+
+  if (!param.acceptVerifiedWrite())  { initArrayReadback(param);  return; }
+
+  if (ShowBlkWrites())
+    log->info(str(format(" === %s:%s: CRCs of the %u blocks written match "
+                         "===\n") % portName % param.name % numCmds));
+
+  activeArrayReads.erase(ParamID(param));
+  auto cache = pmemCaches.find(ParamID(param));
+  if (cache != pmemCaches.end())  cache->second->store(param.arrayValRead);
+  setArrayOperStatus(param);
+  param.setReadPending();
+  schedulePost();
+}
+
 //----------------------------------------------------------------------------
-void drvFGPDB::initArrayReadback(ParamInfo &param)
+void drvFGPDB::initArrayReadback(ParamInfo &param, bool verifyOnly)
 {
-  param.initBlockRW(param.arrayValRead.size());
+  lock_guard<drvFGPDB> asynLock(*this);
+
+  if (!verifyOnly or !param.initVerify())
+    param.initBlockRW(param.arrayValRead.size());
   param.readState = ReadState::Update;
+  activeArrayReads.insert(ParamID(param));
 
   arrayReadsTimer.restart();
 }
@@ -1746,11 +3410,12 @@ asynStatus drvFGPDB::setArrayOperStatus(ParamInfo &param)
 
   if (statusParamID < 0) return asynError;
 
-  U32 arraySize = param.getArraySize();
-  if (arraySize == 0)  return asynError;
+  if (param.getArraySize() == 0)  return asynError;
 
-  U32 ttl = arraySize - param.getBytesLeft();
-  U32 percDone = (U32)((float)ttl / arraySize * 100.0);
+  // progress of a write is relative to the blocks it changes
+  U32 workSize = param.getWorkSize();
+  U32 ttl = workSize - param.getWorkLeft();
+  U32 percDone = workSize ? (U32)((float)ttl / workSize * 100.0) : 100;
 
   ParamInfo &statusParam = params.at(statusParamID);
 
@@ -1789,6 +3454,52 @@ asynStatus drvFGPDB::readInt8Array(asynUser *pasynUser, epicsInt8 *value,
   return asynSuccess;
 }
 
+//----------------------------------------------------------------------------
+//  Copy the most recently posted values of a waveform param
+//----------------------------------------------------------------------------
+template <typename T>
+static asynStatus copyWaveformVals(const vector<T> &vals, T *value,
+                                   size_t nElements, size_t *nIn)
+{
+  size_t count = min(nElements, vals.size());
+
+  copy(vals.begin(), vals.begin() + count, value);
+
+  *nIn = count;
+
+  return vals.empty() ? asynError : asynSuccess;
+}
+
+//----------------------------------------------------------------------------
+asynStatus drvFGPDB::readInt32Array(asynUser *pasynUser, epicsInt32 *value,
+                                    size_t nElements, size_t *nIn)
+{
+  if (!validParamID(pasynUser->reason))  return asynError;
+
+  return copyWaveformVals(params.at(pasynUser->reason).wfInt32, value,
+                          nElements, nIn);
+}
+
+//----------------------------------------------------------------------------
+asynStatus drvFGPDB::readFloat32Array(asynUser *pasynUser, epicsFloat32 *value,
+                                      size_t nElements, size_t *nIn)
+{
+  if (!validParamID(pasynUser->reason))  return asynError;
+
+  return copyWaveformVals(params.at(pasynUser->reason).wfFloat32, value,
+                          nElements, nIn);
+}
+
+//----------------------------------------------------------------------------
+asynStatus drvFGPDB::readFloat64Array(asynUser *pasynUser, epicsFloat64 *value,
+                                      size_t nElements, size_t *nIn)
+{
+  if (!validParamID(pasynUser->reason))  return asynError;
+
+  return copyWaveformVals(params.at(pasynUser->reason).wfFloat64, value,
+                          nElements, nIn);
+}
+
 //-----------------------------------------------------------------------------
 asynStatus drvFGPDB::writeInt8Array(asynUser *pasynUser, epicsInt8 *values,
                                     size_t nElements)
@@ -1815,7 +3526,13 @@ asynStatus drvFGPDB::writeInt8Array(asynUser *pasynUser, epicsInt8 *values,
   param.arrayValSet.assign(&values[0], &values[nElements]);
 
   param.initBlockRW(param.arrayValSet.size());
-  param.setState = SetState::Pending;
+  param.findChgdBlocks();  // only the blocks that differ are erased/written
+
+  // the cached image no longer matches the ctlr until the readback is done
+  auto cache = pmemCaches.find(paramID);
+  if (cache != pmemCaches.end())  cache->second->invalidate();
+  updateSetting(param, SetState::Pending);
+  activeArrayWrites.insert(paramID);
 
   setArrayOperStatus(param);  // init the status param
 
@@ -14,9 +14,14 @@
 
 #include <string>
 #include <vector>
+#include <set>
+#include <map>
+#include <array>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <chrono>
 #include <cstddef>
 
@@ -24,6 +29,7 @@
 
 #include "asynOctetSyncIOInterface.h"
 #include "ParamInfo.h"
+#include "PmemCache.h"
 #include "LCPProtocol.h"
 #include "logger.h"
 #include "eventTimer.h"
@@ -36,7 +42,7 @@ const uint32_t  ShowContents_   = 0x00000002; //!< Show content sent to ctlr
 const uint32_t  ShowRegWrites_  = 0x00000004; //!< Show register writes info
 const uint32_t  ShowRegReads_   = 0x00000008; //!< Show register reads info
 
-const uint32_t  ShowWaveReads_  = 0x00000010; //!< Show waveform reads info              @warning TODO: Not currently used
+const uint32_t  ShowWaveReads_  = 0x00000010; //!< Show waveform reads info
 const uint32_t  ShowBlkWrites_  = 0x00000020; //!< Show memory block writes info
 const uint32_t  ShowBlkReads_   = 0x00000040; //!< Show memory block reads info
 const uint32_t  ShowBlkErase_   = 0x00000080; //!< Show memory block erase info
@@ -54,11 +60,174 @@ const uint32_t  ShowCallbacks_  = 0x00010000; //!< Show eventTimer callbacks
 
 
 /**
- * @brief Stores the IDs of all registered params from one processing group.
+ * @brief Stores the IDs of all registered params from one processing group,
+ *        and a shadow of their values and states indexed by reg offset (so
+ *        the poll and write paths can scan a group without visiting the
+ *        ParamInfo objects).
  */
 class ProcGroup {
   public:
     std::vector<int>  paramIDs;  //!< ID of each param in this processing group
+
+    std::vector<uint32_t>  respShadow;  //!< last accepted value of each reg @note network byte order!
+    std::vector<uint64_t>  unreadBits;  //!< regs without an accepted value since the last reset (bit u % 64 of word u / 64)
+
+    std::vector<uint32_t>  setVals;     //!< copy of the ctlrValSet of each reg's param @note host byte order
+    std::vector<uint8_t>   setStates;   //!< copy of the setState of each reg's param (as a uint8_t)
+
+    /**
+     * @brief Method that resizes the shadow to the size of the group.  The
+     *        regs added since the last resize are flagged as unread.
+     */
+    void resizeShadow();
+
+    /**
+     * @brief Method that returns the offset of the next reg with a setting in
+     *        a given state
+     *
+     * @param[in] first offset to start looking from
+     * @param[in] state the setState to look for
+     *
+     * @return offset of the reg (setStates.size() if none)
+     */
+    size_t findSetState(size_t first, SetState state) const;
+
+    /**
+     * @brief Method that flags all the regs as unread (so their next values
+     *        are passed on to their params even if they didn't change)
+     */
+    void markAllUnread();
+
+    /**
+     * @brief Method to know if any reg in a range is flagged as unread
+     *
+     * @param[in] first offset of the 1st reg
+     * @param[in] count # of regs
+     *
+     * @return true/false
+     */
+    bool anyUnread(size_t first, size_t count) const;
+
+    /**
+     * @brief Method to save the value accepted for a reg
+     *
+     * @param[in] offset  offset of the reg
+     * @param[in] rawVal  value in network byte order
+     */
+    void setRegRead(size_t offset, uint32_t rawVal)  {
+      respShadow[offset] = rawVal;
+      unreadBits[offset / 64] &= ~(uint64_t(1) << (offset % 64)); }
+};
+
+/**
+ * @brief The READ_REGS cmds for the LCP regs in one scan class.  They are
+ *        reused for each poll cycle (only the packet ID changes).
+ */
+class PollPlan {
+  public:
+    PollPlan() : numROCmds(0) {}
+
+    std::vector<LCPReadRegs>  readCmds;  //!< cmds for the ranges of regs, in group order
+    std::vector<LCPCmdBase *> cmds;      //!< pointers to the cmds in readCmds
+    size_t  numROCmds;                   //!< # of cmds at the start of readCmds that read the RO group
+};
+
+/**
+ * @brief The IDs of the params with new readings to be posted, sorted by asyn
+ *        type so the values of each type are converted and passed to the asyn
+ *        param library in one pass.
+ */
+class PostBatches {
+  public:
+    /**
+     * @brief Method that adds a param to the batch for its asyn type
+     *
+     * @param[in] paramID   ID of the param
+     * @param[in] asynType  asyn type of the param
+     */
+    void add(int paramID, asynParamType asynType);
+
+    /**
+     * @brief Method that empties all the batches (keeping their capacity)
+     */
+    void clear();
+
+    /**
+     * @brief Method to know if there is nothing to post
+     */
+    bool empty() const {
+      return int32IDs.empty() and digitalIDs.empty() and float64IDs.empty()
+             and arrayIDs.empty(); }
+
+    std::vector<int>     int32IDs;     //!< Int32 params
+    std::vector<int>     digitalIDs;   //!< UInt32Digital params
+    std::vector<int>     float64IDs;   //!< Float64 params
+    std::vector<double>  float64Vals;  //!< converted values for float64IDs
+    std::vector<int>     arrayIDs;     //!< array, waveform and any other params (posted one at a time)
+};
+
+/**
+ * @brief State of an LCP command that was sent to the ctlr and is waiting for
+ *        its response.
+ */
+class InFlightCmd {
+  public:
+    LCPCmdBase *LCPCmd;  //!< the cmd (its respBuf receives the response)
+    uint32_t  pktID;     //!< packet ID assigned to the cmd
+    int       attempts;  //!< # of times the cmd was sent so far
+    std::chrono::steady_clock::time_point  sendTime;    //!< when the cmd was last sent
+    std::chrono::steady_clock::time_point  rcvTime;     //!< when the response was rcvd
+    std::chrono::steady_clock::time_point  resendTime;  //!< when to send the cmd (again)
+};
+
+/**
+ * @brief Smoothed round-trip time estimate for a type of LCP command (see
+ *        Jacobson/Karels) used to derive the retransmit timeout.
+ */
+class RTTEstimator {
+  public:
+    /**
+     * @brief Constructor for an RTTEstimator
+     *
+     * @param[in] minRTO_  lower limit for the RTO (secs)
+     */
+    explicit RTTEstimator(double minRTO_ = MinRTO) :
+        srtt(0.0), rttVar(0.0), numSamples(0), minRTO(minRTO_) {}
+
+    /**
+     * @brief Method to update the estimate with a new RTT measurement.  Only
+     *        use the RTT for cmds that were sent once (Karn's algorithm).
+     *
+     * @param[in] rtt  measured round trip time (in secs)
+     */
+    void addSample(double rtt);
+
+    /**
+     * @brief Method that returns the retransmit timeout for an attempt
+     *
+     * @param[in] attempt  # of times the cmd was sent so far (1 = first)
+     *
+     * @return # of secs to wait for a response before resending the cmd
+     */
+    double getRTO(int attempt) const;
+
+    /**
+     * @brief Method that returns the smoothed RTT
+     *
+     * @return RTT (in secs) or 0 if no samples yet
+     */
+    double getSRTT() const { return srtt; }
+
+    static constexpr double InitialRTO = 0.2;  //!< RTO until the 1st sample
+    static constexpr double MinRTO = 0.01;     //!< Default lower limit for the RTO
+    static constexpr double MaxRTO = 0.5;      //!< Upper limit for the RTO (incl backoff)
+    static constexpr double EraseMinRTO = 0.2; //!< Lower limit for ERASE_BLOCK cmds (the ctlr replies when the erase is done)
+
+  private:
+    double  srtt;        //!< smoothed RTT (secs)
+    double  rttVar;      //!< smoothed mean deviation of the RTT (secs)
+    unsigned numSamples; //!< # of samples used so far
+    double  minRTO;      //!< lower limit for the RTO (secs)
 };
 
 /**
@@ -144,6 +313,15 @@ class drvFGPDB : public asynPortDriver {
      */
     void completeArrayParamInit ();
 
+    /**
+     * @brief Method to enable the on-disk cache of the PMEM array values.
+     *        Must be called before iocInit (the cache files are opened by
+     *        completeArrayParamInit()).
+     *
+     * @param[in] dir directory for the cache files (one per array param)
+     */
+    void setPmemCacheDir(const std::string &dir) { pmemCacheDir = dir; }
+
 
     /**
      * @brief Returns the value for an integer from the parameter library.
@@ -236,6 +414,24 @@ class drvFGPDB : public asynPortDriver {
     virtual asynStatus writeInt8Array(asynUser *pasynUser, epicsInt8 *values,
                                       size_t nElements) override;
 
+    /**
+     * @brief Methods called by EPICS client to read the most recent values of
+     *        a waveform param
+     *
+     * @param[in]  pasynUser structure that encodes the reason and address
+     * @param[out] value     array read
+     * @param[in]  nElements max number of elements to read
+     * @param[out] nIn       number of elements read
+     *
+     * @return asynStatus
+     */
+    virtual asynStatus readInt32Array(asynUser *pasynUser, epicsInt32 *value,
+                                      size_t nElements, size_t *nIn) override;
+    virtual asynStatus readFloat32Array(asynUser *pasynUser, epicsFloat32 *value,
+                                        size_t nElements, size_t *nIn) override;
+    virtual asynStatus readFloat64Array(asynUser *pasynUser, epicsFloat64 *value,
+                                        size_t nElements, size_t *nIn) override;
+
     /**
      * @brief Returns the number of registered params in the driver
      *
@@ -263,7 +459,7 @@ class drvFGPDB : public asynPortDriver {
      *
      * @param[in] val new diagnostic flag
      */
-    void setDiagFlags(uint32_t val) { diagFlags = val; };
+    void setDiagFlags(uint32_t val) { diagFlags = val;  drvValueChgd(idDiagFlags); };
 
 
 #ifndef TEST_DRVFGPDB
@@ -287,6 +483,28 @@ class drvFGPDB : public asynPortDriver {
      *        - @b setStates changed from @b Restored to @b Sent
      */
     void clearSetStates(void);
+
+    /**
+     * @brief Method that changes the setState of a param.  For an LCP reg,
+     *        the param's ctlrValSet and new state are also copied to the
+     *        shadow in its ProcGroup.  Caller must hold the asyn lock.
+     *
+     * @note  All changes to a setState (and to the ctlrValSet of an LCP reg)
+     *        must go through here, or the write path, which only scans the
+     *        shadow, will not see them.
+     *
+     * @param[in] param    the param
+     * @param[in] newState new setState
+     */
+    void updateSetting(ParamInfo &param, SetState newState);
+
+    /**
+     * @brief Method to know if any LCP reg has a Pending setting
+     *
+     * @return true/false
+     */
+    bool pendingRegSettings(void);
+
     /**
      * @brief Method to abort any Pending/incomplete array write operations
      */
@@ -339,6 +557,28 @@ class drvFGPDB : public asynPortDriver {
      */
     double processScalarReads(void);
 
+    /**
+     * @brief Event-timer callback func to update the readings of the LCP
+     *        regs in one of the named scan classes
+     *
+     * @param[in] scanClass the scan class to read
+     *
+     * @return > 0: Use returned time until next callback
+     *           0: Use Default time until next callback
+     *         < 0: Sleep unless/until woken up
+     */
+    double processScanClass(ScanClass scanClass);
+
+    /**
+     * @brief Method that returns the interval between the reads of the regs
+     *        in a scan class
+     *
+     * @param[in] scanClass the scan class
+     *
+     * @return # of secs
+     */
+    static double scanPeriod(ScanClass scanClass);
+
     /**
      * @brief Event-timer callback func to process pending/ongoing reads of
      *        array values
@@ -359,6 +599,26 @@ class drvFGPDB : public asynPortDriver {
      */
     double processArrayWrites(void);
 
+    /**
+     * @brief Event-timer callback func to send pending settings for scalar
+     *        LCP register params to the controller (see writePendingRegs())
+     *
+     * @return > 0: Use returned time until next callback
+     *           0: Use Default time until next callback
+     *         < 0: Sleep unless/until woken up
+     */
+    double processScalarWrites(void);
+
+    /**
+     * @brief Event-timer callback func to read the ctlr waveforms every
+     *        wfInterval ms
+     *
+     * @return > 0: Use returned time until next callback
+     *           0: Use Default time until next callback
+     *         < 0: Sleep unless/until woken up
+     */
+    double processWaveformReads(void);
+
     /*
      * @brief Event-timer callback func to post any changes to the readings
      *
@@ -366,6 +626,24 @@ class drvFGPDB : public asynPortDriver {
      */
     double postNewReadings(void);
 
+    /**
+     * @brief Method that schedules a call to postNewReadings() within
+     *        postWindow ms.  Calls made while one is already scheduled are
+     *        merged in to the same callback pass.
+     */
+    void schedulePost(void);
+
+    /**
+     * @brief Method that passes the values in postBatches to the asyn param
+     *        library and updates the read state of the params.  Caller must
+     *        hold the asyn lock.
+     *
+     * @param[out] chgsToBePosted set to true if any value was updated
+     *
+     * @return asynStatus
+     */
+    asynStatus publishBatches(bool &chgsToBePosted);
+
     /**
      * @brief Event-timer callback func to check if the ctlr is connected,
      *        disconnected or was rebooted
@@ -445,6 +723,19 @@ class drvFGPDB : public asynPortDriver {
      */
     asynStatus sendMsg(asynUser *pComPort, std::vector<uint32_t> &cmdBuf);
 
+    /**
+     * @brief Method that sends several cmds to the ctlr at once (with a
+     *        single call to the syncIO interface)
+     *
+     * @param[in] pComPort UDP port to communicate with
+     * @param[in] cmdBufs  the cmds to send
+     * @param[in] numMsgs  # of cmds in cmdBufs (max MaxPktsInFlight)
+     *
+     * @return asynSuccess if all of them were sent
+     */
+    asynStatus sendMsgs(asynUser *pComPort,
+                        std::vector<uint32_t> * const cmdBufs[], size_t numMsgs);
+
     /**
      * @brief Method that calls syncIO interface to perform the action
      *        described in cmdBuf
@@ -456,6 +747,19 @@ class drvFGPDB : public asynPortDriver {
      */
     size_t readResp(asynUser *pComPort, std::vector<uint32_t> &respBuf);
 
+    /**
+     * @brief Same as readResp(pComPort, respBuf), but waits at most the
+     *        specified # of seconds for a response
+     *
+     * @param[in]  pComPort UDP port to communicate with
+     * @param[out] respBuf  vector that stores the response
+     * @param[in]  timeout  max # of secs to wait for a response
+     *
+     * @return # bytes read or -1 if an error
+     */
+    size_t readResp(asynUser *pComPort, std::vector<uint32_t> &respBuf,
+                    double timeout);
+
     /**
      * @brief Method that takes care of all the actions performed to the ctlr.
      *        Initializes all buffers needed and checks correct content between the
@@ -469,6 +773,141 @@ class drvFGPDB : public asynPortDriver {
     asynStatus sendCmdGetResp(asynUser *pComPort,
                               LCPCmdBase &LCPCmd,
                               LCPStatus  &respStatus);
+
+    /**
+     * @brief Method that sends a list of LCP commands to the ctlr, keeping up
+     *        to maxPktsInFlight of them outstanding at any time, and collects
+     *        the response for each of them (matched by packet ID).
+     *
+     *        Each command is sent up to maxAttempts times, just like a
+     *        single command sent with sendCmdGetResp().  A failed command does
+     *        not stop the others from being processed.  Use
+     *        LCPCmdBase::respRcvd() to check which commands got a response.
+     *
+     * @note  Must NOT be called with the asyn lock held.  The lock is only
+     *        taken (briefly) to update the driver state for the responses.
+     *
+     * @param[in]     pComPort UDP port to communicate with
+     * @param[in,out] LCPCmds  LCP commands to send (their responses are
+     *                         stored in each cmd's response buffer)
+     * @param[in]     numCmds  number of commands in LCPCmds
+     * @param[in]     maxAttempts max # of times each command is sent
+     * @param[in]     respTimeout secs to wait for each response (0 == use
+     *                         the RTO of the RTT estimator for the command)
+     *
+     * @return asynSuccess if all commands got a response
+     */
+    asynStatus sendCmdsGetResps(asynUser *pComPort,
+                                LCPCmdBase * const LCPCmds[], size_t numCmds,
+                                int maxAttempts = MaxMsgAttempts,
+                                double respTimeout = 0.0);
+
+    /**
+     * @brief Method that returns the packet ID for the next synchronous cmd.
+     *        The IDs wrap within ~AsyncPktIDFlag and skip 0, so they can never
+     *        be mistaken for a stream subscription's packets.
+     *
+     * @return the new value of syncPktID
+     */
+    uint32_t nextSyncPktID(void);
+
+    /**
+     * @brief Body of the thread that receives all the datagrams sent by the
+     *        ctlr (see rcvPkts()), using its own asynUser (pAsynUserRcv).
+     *        Runs until exitDriver is set.
+     */
+    void processResponses(void);
+
+    /**
+     * @brief Method that reads the datagrams the ctlr sent (up to
+     *        RcvBatchSize of them, waiting only for the 1st one) and passes
+     *        each of them to dispatchResp().  The datagrams are counted
+     *        without taking the asyn lock (see rcvdPktCount).
+     *
+     * @param[in] pComPort UDP port to communicate with
+     * @param[in] timeout  max # of secs to wait for a datagram
+     *
+     * @return # of datagrams read or -1 if an error
+     */
+    int rcvPkts(asynUser *pComPort, double timeout);
+
+    /**
+     * @brief Method that passes a datagram from the ctlr to the cmd waiting
+     *        for it (matched by packet ID and LCP command).  Datagrams that
+     *        no cmd is waiting for (late or duplicate responses) are dropped.
+     *
+     * @param[in] rcvBuf   the datagram
+     * @param[in] respLen  # of bytes in the datagram
+     *
+     * @return false if the datagram was dropped (so the caller can count it
+     *         in latePktCount)
+     */
+    bool dispatchResp(const std::vector<uint32_t> &rcvBuf, size_t respLen);
+
+    /**
+     * @brief Method that (re)subscribes to, renews or cancels the stream of
+     *        RO group values pushed by the ctlr, based on streamInterval and
+     *        on when the last pushed values arrived
+     */
+    void updateStream(void);
+
+    /**
+     * @brief Method that sends a READ_REGS cmd for the RO group with the
+     *        specified interval, using a new async packet ID.  The ctlr's
+     *        responses are handled by applyStreamResp().
+     *
+     * @param[in] interval # of ms between pushed values (0 to cancel)
+     *
+     * @return asynStatus
+     */
+    asynStatus sendStreamReq(uint32_t interval);
+
+    /**
+     * @brief Method that applies the RO group values pushed by the ctlr.
+     *        Called by the receiver thread for datagrams with an async packet
+     *        ID.
+     *
+     * @param[in] rcvBuf   the datagram
+     * @param[in] respLen  # of bytes in the datagram
+     */
+    void applyStreamResp(const std::vector<uint32_t> &rcvBuf, size_t respLen);
+
+    /**
+     * @brief Method that updates the writeAccess state based on the sessionID
+     *        returned in a response from the ctlr
+     *
+     * @param[in] respSessionID sessionID from the response packet
+     */
+    void updateWriteAccess(uint32_t respSessionID);
+
+    /**
+     * @brief Method that updates the driver state (flags, write access, RTT
+     *        estimates) for cmds that got a response.  Takes the asyn lock.
+     *
+     * @param[in] doneCmds cmds that got a response
+     * @param[in] numDone  # of cmds in doneCmds
+     */
+    void finishCmds(const InFlightCmd doneCmds[], size_t numDone);
+
+    /**
+     * @brief Method that returns the RTT estimate used for a cmd: register
+     *        cmds, PMEM read/write block cmds and ERASE_BLOCK cmds have
+     *        separate estimates.
+     *
+     * @param[in] LCPCmd the LCP command
+     *
+     * @return reference to the estimate
+     */
+    RTTEstimator & rttEstimator(LCPCmdBase &LCPCmd);
+
+    /**
+     * @brief Method that updates the RTT estimate for a cmd that was sent
+     *        just once and the driver-only param that shows the estimate
+     *
+     * @param[in] cmd  the cmd that got its response
+     */
+    void updateRTT(const InFlightCmd &cmd);
+
     /**
      * @brief Method that reads the ctlr's current values for one or more LCP registers
      *
@@ -479,6 +918,18 @@ class drvFGPDB : public asynPortDriver {
      */
     asynStatus readRegs(epicsUInt32 firstReg, unsigned int numRegs);
 
+    /**
+     * @brief Method that updates the read values of the params for the
+     *        registers included in the response to a READ_REGS command
+     *
+     * @note  Caller must hold the asyn lock
+     *
+     * @param[in] readCmd READ_REGS command with a valid response
+     *
+     * @return asynStatus
+     */
+    asynStatus applyReadRegsResp(LCPReadRegs &readCmd);
+
     /**
      * @brief Method that sends the driver's current value for one or more
      *        writeable LCP registers to the LCP controller
@@ -490,6 +941,53 @@ class drvFGPDB : public asynPortDriver {
      */
     asynStatus writeRegs(epicsUInt32 firstReg, unsigned int numRegs);
 
+    /**
+     * @brief Method that sends all the pending settings for LCP registers,
+     *        merged in to the fewest WRITE_REGS cmds that cover each run of
+     *        contiguous registers in a group (all of them in flight at the
+     *        same time)
+     *
+     * @return asynError if some of the settings could not be sent (they are
+     *         left Pending), otherwise asynSuccess
+     */
+    asynStatus writePendingRegs(void);
+
+    /**
+     * @brief Method that copies the settings for the registers in a
+     *        WRITE_REGS cmd to the cmd and sets their state to Processing.
+     *        Caller must hold the asyn lock.
+     *
+     * @param[in] writeCmd cmd for the range of registers to write
+     *
+     * @return asynError if a register in the range is not defined
+     */
+    asynStatus loadWriteRegsCmd(LCPWriteRegs &writeCmd);
+
+    /**
+     * @brief Method that updates the setState of the params written by a
+     *        WRITE_REGS cmd (only the ones that are still Processing).  The
+     *        asyn status of a param is set to asynError if its setting was
+     *        rejected, and back to asynSuccess once a setting is sent.
+     *        Caller must hold the asyn lock.
+     *
+     * @param[in] writeCmd cmd for the range of registers written
+     * @param[in] newState Sent, Pending (to retry) or Error
+     *
+     * @return true if the asyn status of any of the params changed (so the
+     *         caller must call callParamCallbacks())
+     */
+    bool finishWriteRegsCmd(LCPWriteRegs &writeCmd, SetState newState);
+
+    /**
+     * @brief Method that returns the max # of register values that fit in one
+     *        WRITE_REGS datagram
+     *
+     * @param[in] mtu  max size (bytes) of the IP datagrams
+     *
+     * @return # of registers (0 if the MTU is too small)
+     */
+    static uint32_t maxWriteRegsCount(uint32_t mtu);
+
     /**
      * @brief Method that updates the state of the specified asyn param
      *
@@ -504,9 +1002,139 @@ class drvFGPDB : public asynPortDriver {
      *        and local driver variables) and updates the read state of the
      *        corresponding ParamInfo objects
      *
+     * @param[in] scanClass the scan class of the LCP regs to read (the
+     *                      driver-only values are read with the Default one)
+     *
      * @return asynStatus
      */
-    asynStatus updateScalarReadValues();
+    asynStatus updateScalarReadValues(ScanClass scanClass = ScanClass::Default);
+
+    /**
+     * @brief Method that updates the read value of a driver-only param from
+     *        its local variable (if it changed).  Caller must hold the asyn
+     *        lock.
+     *
+     * @param[in] param driver-only param with a drvValue
+     */
+    void refreshDrvValue(ParamInfo &param);
+
+    /**
+     * @brief Method that builds the index of the driver-only params with a
+     *        local variable that updateScalarReadValues() refreshes
+     */
+    void buildDrvValueIndex();
+
+    /**
+     * @brief Method that returns the bit used to flag a change to the local
+     *        variable of a driver-only param
+     *
+     * @param[in] paramID ID of the param
+     *
+     * @return bit in drvValuesChgd (0 if the param can't be flagged)
+     */
+    static uint64_t drvValueBit(int paramID) {
+      return ((paramID >= 0) and (paramID < MaxFlaggedDrvValues)) ?
+             (uint64_t(1) << paramID) : 0; }
+
+    /**
+     * @brief Method to flag a change to the local variable of a driver-only
+     *        param so the next refresh posts its new value
+     *
+     * @param[in] paramID ID of the param
+     */
+    void drvValueChgd(int paramID) { drvValuesChgd |= drvValueBit(paramID); }
+
+    /**
+     * @brief Method that (re)builds the poll plans: the READ_REGS cmds for
+     *        the LCP regs in each scan class, which are then reused for each
+     *        poll cycle.  Called by startCommunication() and again by
+     *        updateScalarReadValues() if the reg map or the MTU changed.
+     */
+    void buildPollPlan();
+
+    /**
+     * @brief Method that returns true if the poll plan matches the current
+     *        reg map and MTU
+     */
+    bool pollPlanValid();
+
+    /**
+     * @brief Method that splits the regs of a group in to the READ_REGS ranges
+     *        with the lowest cost.  Each cmd costs the bytes of its cmd and
+     *        resp headers, and each reg read costs 4 bytes, so undefined regs
+     *        are only read when that is cheaper than an extra cmd.  No range
+     *        is longer than maxCount.
+     *
+     * @param[in] paramIDs  ID of the param for each reg in the group (-1 if none)
+     * @param[in] maxCount  max # of regs per READ_REGS cmd
+     *
+     * @return offset (within the group) and count of each range
+     */
+    static std::vector<std::pair<uint32_t, uint32_t>> planRegReads(
+        const std::vector<int> &paramIDs, uint32_t maxCount);
+
+    /**
+     * @brief Method that returns the max # of register values that fit in one
+     *        READ_REGS response datagram
+     *
+     * @param[in] mtu  max size (bytes) of the IP datagrams
+     *
+     * @return # of registers (0 if the MTU is too small)
+     */
+    static uint32_t maxReadRegsCount(uint32_t mtu);
+
+    /**
+     * @brief Method that returns the largest power-of-2 # of PMEM data bytes
+     *        that fit in a datagram
+     *
+     * @param[in] mtu max size (in bytes) of an IP datagram
+     *
+     * @return # of bytes (0 if not even 4 bytes fit)
+     */
+    static uint32_t maxPmemPayload(uint32_t mtu);
+
+    /**
+     * @brief Method that splits a PMEM block in to the fewest sub-blocks that
+     *        fit in etherMTU
+     *
+     * @param[in]  blockSize    size (in bytes) of the block (a power of 2)
+     * @param[in]  blockNum     block number (relative to blockSize)
+     * @param[out] useBlockSize size of each sub-block
+     * @param[out] useBlockNum  block number of the first sub-block (relative
+     *                          to useBlockSize)
+     * @param[out] subBlocks    # of sub-blocks
+     *
+     * @return asynError if the block can't be split that way
+     */
+    asynStatus splitBlock(uint32_t blockSize, uint32_t blockNum,
+                          uint32_t &useBlockSize, uint32_t &useBlockNum,
+                          unsigned int &subBlocks);
+
+    /**
+     * @brief Method that looks for the largest MTU (up to probeMTU) that
+     *        works for PMEM transfers and, if larger than etherMTU, uses it
+     *
+     * @return asynSuccess if a larger MTU was found
+     */
+    asynStatus probeEtherMTU(void);
+
+    /**
+     * @brief Method that prepares the PMEM block cmds for a transfer, reusing
+     *        the cmds (and their buffers) from the last transfer if they are
+     *        for the same block size
+     *
+     * @param[in,out] cmds         reusable cmds (LCPReadBlock or LCPWriteBlock)
+     * @param[out]    LCPCmds      pointers to the first numCmds entries in cmds
+     * @param[in]     chipNum      memory chip to access
+     * @param[in]     blockSize    size (in bytes) of each sub-block
+     * @param[in]     firstBlockNum block number of the first sub-block
+     * @param[in]     numCmds      # of sub-blocks
+     */
+    template <class BlockCmd>
+    void prepBlockCmds(std::vector<BlockCmd> &cmds,
+                       std::vector<LCPCmdBase *> &LCPCmds, unsigned int chipNum,
+                       uint32_t blockSize, uint32_t firstBlockNum,
+                       unsigned int numCmds);
 
     /**
      * @brief Method to search a given param
@@ -617,7 +1245,75 @@ class drvFGPDB : public asynPortDriver {
                           uint32_t blockNum, std::vector<uint8_t> &rwBuf);
 
     /**
-     * @brief Method that reads next block of a PMEM array value from the ctlr
+     * @brief Method that returns the max # of waveform values that fit in one
+     *        READ_WAVEFORM response datagram
+     *
+     * @param[in] mtu  max size (bytes) of the IP datagrams
+     *
+     * @return # of 32-bit values (0 if the MTU is too small)
+     */
+    static uint32_t maxWaveformCount(uint32_t mtu);
+
+    /**
+     * @brief Method that reads all the values of a ctlr waveform in to the
+     *        param's (preallocated) wfValRead buffer.  The read is split in
+     *        to READ_WAVEFORM cmds that fit in the etherMTU, with several of
+     *        them in flight at the same time.
+     *
+     * @param[in] param waveform parameter to read
+     *
+     * @return asynStatus
+     */
+    asynStatus readWaveform(ParamInfo &param);
+
+    /**
+     * @brief Method that posts the converted values of a waveform param to
+     *        the asyn layer.  Caller must hold the asyn lock.
+     *
+     * @param[in] param   waveform parameter
+     * @param[in] numVals # of values to post (0 to post just a status chg)
+     *
+     * @return asynStatus
+     */
+    asynStatus doWaveformCallbacks(ParamInfo &param, size_t numVals);
+
+    /**
+     * @brief Method that gets a param ready for a streaming read of its
+     *        array value: picks the sub-block size for the current etherMTU
+     *        and lists all the sub-blocks to be read.  Caller must hold the
+     *        asyn lock.
+     *
+     * @param[in] param parameter for the array value to be read
+     *
+     * @return asynStatus
+     */
+    asynStatus initReadStream(ParamInfo &param);
+
+    /**
+     * @brief Method that opens the cache file of each array param (if a
+     *        cache dir was set by setPmemCacheDir())
+     */
+    void openPmemCaches(void);
+
+    /**
+     * @brief Method that posts the cached value of each array param that is
+     *        about to be read again, instead of reading it from the ctlr, if
+     *        its cache file is still valid.  Caller must hold the asyn lock.
+     */
+    void publishCachedArrays(void);
+
+    /**
+     * @brief Method that updates the read rate of an array for a streaming
+     *        read (and its rdRateParam, if it has one).  Caller
+     *        must hold the asyn lock.
+     *
+     * @param[in] param parameter for the array value being read
+     */
+    void updateReadRate(ParamInfo &param);
+
+    /**
+     * @brief Method that reads the next burst of sub-blocks of a PMEM array
+     *        value from the ctlr (all of them in flight at the same time)
      *
      * @param[in] param parameter in charge of read PMEM
      *
@@ -634,13 +1330,26 @@ class drvFGPDB : public asynPortDriver {
      */
     asynStatus writeNextBlock(ParamInfo &param);
 
+    /**
+     * @brief Method that checks an array write that just finished, by
+     *        comparing the ctlr's CRC-32C of each block written with the CRC
+     *        of the bytes sent.  Falls back to reading back the blocks
+     *        written (or all of the array) if that can't be done or they
+     *        don't match.
+     *
+     * @param[in] param parameter for the array value written
+     */
+    void verifyArrayWrite(ParamInfo &param);
+
     /**
      * @brief Method that initializes array parameter for readback operation
      *        and insures the readback event timer is active.
      *
-     * @param[in] param parameter for the array value to be read
+     * @param[in] param      parameter for the array value to be read
+     * @param[in] verifyOnly only read back the blocks changed by the write
+     *                       that just finished (see ParamInfo::initVerify())
      */
-    void initArrayReadback(ParamInfo &param);
+    void initArrayReadback(ParamInfo &param, bool verifyOnly = false);
 
     /**
      * @brief Method that sets the status param value to the percentage done
@@ -656,14 +1365,14 @@ class drvFGPDB : public asynPortDriver {
     static const int MaxAddr = 1;    //!< MAX number of asyn addresses supported by this driver
 
     static const int InterfaceMask = asynInt8ArrayMask | asynInt32Mask |
-                                     asynInt32ArrayMask |
+                                     asynInt32ArrayMask | asynFloat32ArrayMask |
                                      asynUInt32DigitalMask | asynFloat64Mask |
                                      asynFloat64ArrayMask | asynOctetMask |
                                      asynDrvUserMask;
                                      //!< Asyn Interfaces supported by the driver
 
     static const int InterruptMask = asynInt8ArrayMask | asynInt32Mask |
-                                     asynInt32ArrayMask |
+                                     asynInt32ArrayMask | asynFloat32ArrayMask |
                                      asynUInt32DigitalMask | asynFloat64Mask |
                                      asynFloat64ArrayMask | asynOctetMask;
                                      //!< Asyn Interfaces that can generate interrupts
@@ -682,15 +1391,47 @@ class drvFGPDB : public asynPortDriver {
                                        */
     static const unsigned int TimerThreadPriority = epicsThreadPriorityMedium;
 
+    static const int MaxMsgAttempts = 5;  //!< Max # of times a cmd is sent to the ctlr
+
+    static constexpr double MTUProbeTimeout = 0.1;  //!< secs to wait for the response to each MTU probe
+
+    static const uint32_t MaxPktsInFlight = 32;  //!< Upper limit for maxPktsInFlight
+
+    static const size_t MaxDatagramWords = 16384;  //!< Size of the largest possible UDP datagram (in 32-bit words)
+
+    static const size_t RcvBatchSize = 8;  //!< Max # of datagrams read with one call
+
+    static const uint32_t PmemPktOverhead = 52;  //!< IPv4 + UDP + PMEM resp hdr bytes in a PMEM datagram
+
+    static const uint32_t PmemReadBurstBytes = 0x40000;  //!< Max # of PMEM bytes requested by each call of readNextBlock()
+
+    static const uint32_t WriteRegsPktOverhead = 44;  //!< IPv4 + UDP + WRITE_REGS cmd hdr bytes in a datagram
+
+    static const uint32_t ReadRegsPktOverhead = 48;  //!< IPv4 + UDP + READ_REGS resp hdr bytes in a datagram
+
+    static const uint32_t ReadRegsCmdPktSize = 48;  //!< IPv4 + UDP + READ_REGS cmd bytes in a datagram
+
+    static const uint32_t WaveformPktOverhead = 64;  //!< IPv4 + UDP + READ_WAVEFORM resp hdr bytes in a datagram
+
+    static const int MaxFlaggedDrvValues = 64;  //!< # of bits in drvValuesChgd
+
+    static const size_t NumScanClasses = 4;  //!< # of values in ScanClass
+
+    static const uint32_t AsyncPktIDFlag = 0x80000000;  //!< set in the packet ID of stream subscriptions
+
     epicsTimerQueueActive  &timerQueue;  //<! queue used by timer thread to manage our timer events
 
     eventTimer  writeAccessTimer;     //<! To manage writeAccess keep-alives
     eventTimer  scalarReadsTimer;     //<! To periodically update scalar readings
     eventTimer  arrayReadsTimer;      //<! To process pending reads of array values
     eventTimer  arrayWritesTimer;     //<! To process pending writes to array values
+    eventTimer  scalarWritesTimer;    //<! To send pending settings for scalar LCP regs
+    eventTimer  waveformReadsTimer;   //<! To periodically read the ctlr waveforms
     eventTimer  postNewReadingsTimer; //<! To post the latest readings
     eventTimer  comStatusTimer;       //<! To periodically update status of connection
 
+    std::vector<std::unique_ptr<eventTimer>> scanTimers;  //<! To periodically read the regs in each named scan class
+
     std::thread::id callback_thread_id;
 
 
@@ -727,9 +1468,23 @@ class drvFGPDB : public asynPortDriver {
 
     std::vector<ParamInfo> params;  //!< Vector with all the parameters registered in the driver
 
+    std::vector<int> pendingReadings;  //!< IDs of the params with new readings to be posted (see ParamInfo::setReadPending())
+    std::vector<int> postingReadings;  //!< IDs being posted by postNewReadings()
+    PostBatches  postBatches;          //!< postingReadings sorted by asyn type
+
+    std::atomic<uint64_t> drvValuesChgd;  //!< driver-only values changed since the last refresh (bit # == paramID)
+    uint64_t  allDrvValueBits;            //!< bits for all the driver-only params with a local variable
+    std::vector<int> unflaggedDrvValueIDs; //!< driver-only params with a local variable but no bit (refreshed every time)
+
+    std::set<int> activeArrayReads;    //!< IDs of the array params with a read in progress
+    std::set<int> activeArrayWrites;   //!< IDs of the array params with a write Pending or Processing
+    std::vector<int> arrayReadIDs;     //!< IDs being processed by processArrayReads()
+    std::vector<int> arrayWriteIDs;    //!< IDs being processed by processArrayWrites()
+
     unsigned int ParamID(ParamInfo &param) { return (&param - params.data()); }
 
     asynUser *pAsynUserUDP;          //!< asynUser for UDP asyn port
+    asynUser *pAsynUserRcv;          //!< asynUser for the receiver thread (asynOctetSyncIO keeps the state of each call in the asynUser)
 
     std::atomic<bool> initComplete;  //!< initialization has finished
     std::atomic<bool> exitDriver;    //!< exit the driver. Set to true by epicsAtExit registered function
@@ -742,8 +1497,8 @@ class drvFGPDB : public asynPortDriver {
     bool  firstRestartCheck;         //!< 1st time testing for ctlr restart
 
     bool  connected;
-    std::chrono::system_clock::time_point  lastRespTime,   //!< time of the last response received from the ctlr
-                                           lastWriteTime;  //!< time of last write to the ctlr
+    std::atomic<std::chrono::system_clock::time_point>  lastRespTime;  //!< time of the last response received from the ctlr (set by the receiver thread)
+    std::chrono::system_clock::time_point  lastWriteTime;  //!< time of last write to the ctlr
 
     //=== paramIDs for required parameters ===
     // reg values the ctlr must support
@@ -752,12 +1507,12 @@ class drvFGPDB : public asynPortDriver {
 
     //driver-only values
     int idSyncPktID ;     uint32_t syncPktID;       //!< ID of last packet sent/received
-    int idSyncPktsSent;   uint32_t syncPktsSent;    //!< Updated in sendMsg()
-    int idSyncPktsRcvd;   uint32_t syncPktsRcvd;    //!< Updated in readResp()
+    int idSyncPktsSent;   uint32_t syncPktsSent;    //!< Updated in sendMsg() and sendMsgs()
+    int idSyncPktsRcvd;   uint32_t syncPktsRcvd;    //!< Copied from rcvdPktCount by updateScalarReadValues()
 
-    int idAsyncPktID;     uint32_t asyncPktID;      //!< TODO: Not being used
-    int idAsyncPktsSent;  uint32_t asyncPktsSent;   //!< TODO: Not being used
-    int idAsyncPktsRcvd;  uint32_t asyncPktsRcvd;   //!< TODO: Not being used
+    int idAsyncPktID;     uint32_t asyncPktID;      //!< ID of last stream subscription sent (see AsyncPktIDFlag)
+    int idAsyncPktsSent;  uint32_t asyncPktsSent;   //!< Updated in sendStreamReq()
+    int idAsyncPktsRcvd;  uint32_t asyncPktsRcvd;   //!< Updated in applyStreamResp()
 
     int idStateFlags;     uint32_t stateFlags;      /*< Bits currently used:
                                                         - SyncConActive:  0x00000001
@@ -769,10 +1524,76 @@ class drvFGPDB : public asynPortDriver {
 
     int idCtlrUpSince;    uint32_t ctlrUpSince;     //!< last time ctlr restarted
 
+    int idMaxPktsInFlight;  uint32_t maxPktsInFlight; //!< Max # of cmds waiting for a resp at the same time
+
+    int idEtherMTU;       uint32_t etherMTU;        //!< Max size (bytes) of the IP datagrams for PMEM transfers
+    int idProbeMTU;       uint32_t probeMTU;        //!< If not 0, largest MTU to probe for when the ctlr comes online
+    bool  mtuProbed;      //!< true if the MTU was probed since the ctlr came online
+    uint32_t  probeFailedMTU;      //!< probeMTU the failed payload is for
+    uint32_t  probeFailedPayload;  //!< smallest PMEM payload the MTU probe found not to work (0 if none)
+
+    int idStreamInterval; uint32_t streamInterval;  //!< If not 0, # of ms between RO group values pushed by the ctlr (instead of polling them)
+    uint32_t  streamPktID;            //!< packet ID of the current stream subscription (0 if none)
+    std::atomic<bool>  streamActive;  //!< the ctlr is pushing the RO group values
+    std::chrono::steady_clock::time_point  lastStreamTime,  //!< time the last pushed values were rcvd
+                                           lastStreamReq;   //!< time of the last stream subscription
+
+    int idWriteWindow;    uint32_t writeWindow;     //!< max # of ms a new setting waits to be merged with others in to one WRITE_REGS cmd
+
+    int idPostWindow;     uint32_t postWindow;      //!< max # of ms new readings wait to be merged with others in to one callback pass
+
+    int idWfInterval;     uint32_t wfInterval;      //!< # of ms between reads of the ctlr waveforms (0 to stop reading them)
+
+    int idLatePktsRcvd;   uint32_t latePktsRcvd;    //!< Copied from latePktCount by updateScalarReadValues()
+
+    int idPmemFullReadback; uint32_t pmemFullReadback; //!< If not 0, all of an array is read back after each write (instead of checking the CRC of each block written)
+
+    int idRegRTT;         uint32_t regRTT;          //!< smoothed RTT for register cmds (usecs)
+    int idBlockRTT;       uint32_t blockRTT;        //!< smoothed RTT for PMEM block cmds (usecs)
+
+    RTTEstimator  regRTTEst;    //!< RTT estimate for register (and write access) cmds
+    RTTEstimator  blockRTTEst;  //!< RTT estimate for PMEM read/write block cmds
+    RTTEstimator  eraseRTTEst;  //!< RTT estimate for ERASE_BLOCK cmds (see EraseMinRTO)
+
+    std::array<std::vector<uint32_t>, RcvBatchSize> rcvBufs;  //!< Buffers for datagrams rcvd from the ctlr
+
+    std::thread  rcvThread;        //!< receives all datagrams from the ctlr (see processResponses())
+    std::atomic<uint32_t>  rcvdPktCount;  //!< # of datagrams rcvd (counted by readResp() and rcvPkts() without the asyn lock)
+    std::atomic<uint32_t>  latePktCount;  //!< # of late or duplicate responses dropped (counted by rcvPkts())
+    std::mutex  rcvMutex;          //!< protects inFlight and numInFlight
+    std::mutex  syncIOMutex;       //!< serializes sendCmdsGetResps() (instead of the asyn lock)
+    std::condition_variable  rcvCond;  //!< signaled when a cmd in inFlight gets its response
+
+    std::array<InFlightCmd, MaxPktsInFlight>  inFlight;  //!< cmds waiting for a response
+    size_t  numInFlight;           //!< # of entries used in inFlight
+
+    std::unique_ptr<LCPReadRegs>  streamReadCmd;  //!< the stream subscription and the last values pushed by the ctlr
+    std::array<PollPlan, NumScanClasses>  pollPlans;  //!< READ_REGS cmds for each scan class
+    std::vector<uint64_t>  chgdRegBits;  //!< regs that changed in the response being applied (see applyReadRegsResp())
+    uint32_t  pollPlanMTU;         //!< etherMTU when the poll plan was built
+    std::atomic<bool>  regMapChgd; //!< a reg was added to a group since the poll plan was built
+
+    std::vector<LCPReadBlock>   readBlockCmds;   //!< reused by readBlock()
+    std::vector<LCPWriteBlock>  writeBlockCmds;  //!< reused by writeBlock()
+    std::vector<LCPChecksumBlock> checksumBlockCmds;  //!< reused by verifyArrayWrite()
+    std::vector<LCPCmdBase *>   blockCmds;       //!< pointers to the block cmds in use
+    std::vector<uint32_t>       burstSubBlocks;  //!< sub-blocks requested by readNextBlock() (in reverse order)
+
+    std::string  ctlrAddr;       //!< {ip}:{port} of the ctlr (the asyn port name if the transport can't tell)
+    std::string  pmemCacheDir;   //!< dir for the PMEM cache files (empty == no cache)
+    std::map<int, std::unique_ptr<PmemCache>>  pmemCaches;  //!< cache file of each array param (by paramID)
+
+    std::vector<LCPWriteRegs>  writeRegsCmds;  //!< cmds in use by writePendingRegs()
+    std::vector<LCPCmdBase *>  writeCmds;      //!< pointers to the cmds in writeRegsCmds
+
+    std::vector<LCPReadWF>     wfReadCmds;  //!< reused by readWaveform()
+    std::vector<LCPCmdBase *>  wfCmds;      //!< pointers to the waveform cmds in use
+
     ResendMode  resendMode;  //!< mode for determining if/when to resend settings to the ctlr
 
     const double writeTimeout = 0.1;
     const double readTimeout  = 0.1;
+    const double rcvPollTimeout = 0.01;  //!< max time the receiver thread waits in each read (an asyn IP port is locked for the whole read)
 
     int  idDiagFlags;     uint32_t diagFlags;
 
@@ -14,10 +14,12 @@
 
 #include "drvFGPDB.h"
 #include "asynOctetSyncIOWrapper.h"
+#include "udpSocketSyncIO.h"
 
 using namespace std;
 
 static shared_ptr<asynOctetSyncIOWrapper> syncIOWrapper;  //!< shared_ptr to the asynOctetSyncIOWrapper
+static shared_ptr<udpSocketSyncIO> udpSocketIO;  //!< shared_ptr to the udpSocketSyncIO (for the "socket" transport)
 static shared_ptr<logger> pLog {
   make_shared<timeDateDecorator>(
     make_shared<threadIDDecorator>(
@@ -62,15 +64,22 @@ void drvFGPDB_initHookFunc(initHookState state)
  *                               the device.
  * @param[in] startupDiagFlags_  Debugging flag
  * @param[in] resendMode         Mode used handle controller and IOC restarts
+ * @param[in] transport          "asyn" (default) to talk to the device through
+ *                               the asyn port udpPortName or "socket" to use
+ *                               a UDP socket directly, in which case
+ *                               udpPortName is the {host}:{port} of the device
  *
  * @return 0 @warning If any std::exception is catched, program will be terminated
  */
 int drvFGPDB_Config(char *drvPortName, char *udpPortName, int startupDiagFlags_,
-                    char *resendMode)
+                    char *resendMode, char *transport)
 {
   if (!syncIOWrapper) {
     syncIOWrapper = make_shared<asynOctetSyncIOWrapper>();
   }
+  if (!udpSocketIO) {
+    udpSocketIO = make_shared<udpSocketSyncIO>();
+  }
   if (!pLog) {
     pLog = make_shared<epicsLogger>();
   }
@@ -82,6 +91,16 @@ int drvFGPDB_Config(char *drvPortName, char *udpPortName, int startupDiagFlags_,
          << "\"" << endl;
     exit(-1);
   }
+  shared_ptr<asynOctetSyncIOInterface> syncIO;
+  if (!transport || string(transport) == "asyn") {
+    syncIO = syncIOWrapper;
+  } else if (string(transport) == "socket") {
+    syncIO = udpSocketIO;
+  } else {
+    cerr << "ERROR: invalid transport \"" << transport << "\" for port \""
+         << drvPortName << "\"" << endl;
+    exit(-1);
+  }
   try{
     string portName = string(drvPortName);
     const std::unordered_map<std::string, ResendMode> resendModeMap {
@@ -90,7 +109,7 @@ int drvFGPDB_Config(char *drvPortName, char *udpPortName, int startupDiagFlags_,
       { "Never",            ResendMode::Never            }
     };
     drvFGPDBs->emplace(piecewise_construct, forward_as_tuple(portName),
-                       forward_as_tuple(portName, syncIOWrapper,
+                       forward_as_tuple(portName, syncIO,
                                         string(udpPortName), startupDiagFlags_,
                                         resendModeMap.at(resendMode), pLog));
   } catch(const std::out_of_range& e) {
@@ -130,6 +149,32 @@ void drvFGPDB_setDiagFlags(char *drvPortName, int diagFlags_)
   }
 }
 
+/**
+ * @brief      EPICS IOC Shell func to enable the on-disk cache of the PMEM
+ *             array values for a given Port.  Must be called before iocInit.
+ *
+ * @param[in]  drvPortName  The name of the asyn port driver
+ * @param[in]  cacheDir     Directory for the cache files
+ */
+void drvFGPDB_setPmemCacheDir(char *drvPortName, char *cacheDir)
+{
+  string portName = string(drvPortName);
+
+  if (!drvFGPDBs) {
+    throw runtime_error("List of drvFGPDB objects doesn't exist! You need to "
+                        "create at least one driver object before calling this "
+                        "function.");
+  }
+
+  auto it = drvFGPDBs->find(portName);
+  if(it == drvFGPDBs->end()) {
+    throw invalid_argument("Can't find drvFGPDB object for port \"" + portName +
+                           "\"");
+  } else {
+    it->second.setPmemCacheDir(string(cacheDir));
+  }
+}
+
 /**
  * @brief EPICS IOC Shell func to retrieve the portNames of the different
  *        driver instances created.
@@ -155,6 +200,7 @@ static void drvFGPDB_cleanUp(void *)
 {
   drvFGPDBs.reset();
   syncIOWrapper.reset();
+  udpSocketIO.reset();
 }
 
 //-----------------------------------------------------------------------------
@@ -166,12 +212,14 @@ static const iocshArg config_Arg0 { "drvPortName", iocshArgString };
 static const iocshArg config_Arg1 { "udpPortName", iocshArgString };
 static const iocshArg config_Arg2 { "startupDiag", iocshArgInt    };
 static const iocshArg config_Arg3 { "resendMode",  iocshArgString };
+static const iocshArg config_Arg4 { "transport",   iocshArgString };
 
 static const iocshArg * const config_Args[] {
   &config_Arg0,
   &config_Arg1,
   &config_Arg2,
-  &config_Arg3
+  &config_Arg3,
+  &config_Arg4
 };
 
 static const iocshFuncDef config_FuncDef {
@@ -182,7 +230,8 @@ static const iocshFuncDef config_FuncDef {
 
 static void config_CallFunc(const iocshArgBuf *args)
 {
-  drvFGPDB_Config(args[0].sval, args[1].sval, args[2].ival, args[3].sval);
+  drvFGPDB_Config(args[0].sval, args[1].sval, args[2].ival, args[3].sval,
+                  args[4].sval);
 }
 
 // IOC-shell command "drvFGPDB_SetDiagFlags"
@@ -214,6 +263,40 @@ static void setDiagFlags_CallFunc(const iocshArgBuf *args)
   }
 }
 
+// IOC-shell command "drvFGPDB_SetPmemCacheDir"
+static const iocshArg setPmemCacheDir_Arg0 { "drvPortName", iocshArgString };
+static const iocshArg setPmemCacheDir_Arg1 { "cacheDir",    iocshArgString };
+
+static const iocshArg * const setPmemCacheDir_Args[] {
+  &setPmemCacheDir_Arg0,
+  &setPmemCacheDir_Arg1
+};
+
+static const iocshFuncDef setPmemCacheDir_FuncDef {
+  "drvFGPDB_SetPmemCacheDir",
+  sizeof(setPmemCacheDir_Args) / sizeof(iocshArg *),
+  setPmemCacheDir_Args
+};
+
+static void setPmemCacheDir_CallFunc(const iocshArgBuf *args)
+{
+  if (args[0].sval == nullptr) {
+    cout << setPmemCacheDir_FuncDef.name << ": ERROR: Parameter "
+         << setPmemCacheDir_Arg0.name << " not specified!" << endl;
+    return;
+  }
+  if (args[1].sval == nullptr) {
+    cout << setPmemCacheDir_FuncDef.name << ": ERROR: Parameter "
+         << setPmemCacheDir_Arg1.name << " not specified!" << endl;
+    return;
+  }
+  try {
+    drvFGPDB_setPmemCacheDir(args[0].sval, args[1].sval);
+  } catch(exception& e) {
+    cout << setPmemCacheDir_FuncDef.name << ": ERROR: " << e.what() << endl;
+  }
+}
+
 // IOC-shell command "drvFGPDB_Report"
 static const iocshFuncDef report_FuncDef {
   "drvFGPDB_Report",
@@ -243,6 +326,7 @@ void drvFGPDB_Register(void)
     initHookRegister(drvFGPDB_initHookFunc);
     iocshRegister(&config_FuncDef, config_CallFunc);
     iocshRegister(&setDiagFlags_FuncDef, setDiagFlags_CallFunc);
+    iocshRegister(&setPmemCacheDir_FuncDef, setPmemCacheDir_CallFunc);
     iocshRegister(&report_FuncDef, report_CallFunc);
     firstTime = false;
   }
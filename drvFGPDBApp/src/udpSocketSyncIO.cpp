@@ -0,0 +1,413 @@
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include "udpSocketSyncIO.h"
+
+using namespace std;
+
+const size_t udpSocketSyncIO::MaxMsgsPerCall;
+
+//-----------------------------------------------------------------------------
+//  Create a UDP socket connected to {host}:{port} and keep its file
+//  descriptor in the asynUser returned to the caller
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::connect(const char *port,
+                                    __attribute__((unused)) int addr,
+                                    asynUser **ppasynUser,
+                                    __attribute__((unused)) const char *drvInfo)
+{
+  string hostInfo(port ? port : "");
+
+  auto sep = hostInfo.rfind(':');
+  if (sep == string::npos)  return asynError;
+
+  string host = hostInfo.substr(0, sep);
+  string service = hostInfo.substr(sep + 1);
+  service = service.substr(0, service.find_first_of(" \t"));
+
+  addrinfo hints {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo *res = nullptr;
+
+  if (getaddrinfo(host.c_str(), service.c_str(), &hints, &res) or !res)
+    return asynError;
+
+  int fd = socket(res->ai_family, res->ai_socktype | SOCK_CLOEXEC,
+                  res->ai_protocol);
+  if ((fd < 0) or ::connect(fd, res->ai_addr, res->ai_addrlen))  {
+    if (fd >= 0)  close(fd);
+    freeaddrinfo(res);
+    return asynError;
+  }
+  freeaddrinfo(res);
+
+  asynUser *pasynUser = pasynManager->createAsynUser(nullptr, nullptr);
+  pasynUser->userPvt = new int(fd);
+  *ppasynUser = pasynUser;
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+//  The new asynUser gets a duplicate of the socket (instead of a new socket
+//  with its own local port), so it receives the responses to the datagrams
+//  sent with the other asynUser
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::connectShared(__attribute__((unused)) const char *port,
+                                          __attribute__((unused)) int addr,
+                                          asynUser *pasynUser,
+                                          asynUser **ppasynUser,
+                                          __attribute__((unused)) const char *drvInfo)
+{
+  int fd = socketFD(pasynUser);
+  if (fd < 0)  return asynDisconnected;
+
+  int dupFD = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if (dupFD < 0)  return asynError;
+
+  asynUser *pasynUserDup = pasynManager->createAsynUser(nullptr, nullptr);
+  pasynUserDup->userPvt = new int(dupFD);
+  *ppasynUser = pasynUserDup;
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::disconnect(asynUser *pasynUser)
+{
+  if (!pasynUser)  return asynError;
+
+  int *pfd = static_cast<int *>(pasynUser->userPvt);
+  if (pfd)  { close(*pfd);  delete pfd; }
+  pasynUser->userPvt = nullptr;
+
+  pasynManager->freeAsynUser(pasynUser);
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+string udpSocketSyncIO::peerAddr(asynUser *pasynUser)
+{
+  int fd = socketFD(pasynUser);
+  if (fd < 0)  return string();
+
+  sockaddr_storage addr {};
+  socklen_t addrLen = sizeof(addr);
+  char host[NI_MAXHOST], service[NI_MAXSERV];
+  if (getpeername(fd, reinterpret_cast<sockaddr *>(&addr), &addrLen) or
+      getnameinfo(reinterpret_cast<sockaddr *>(&addr), addrLen, host,
+                  sizeof(host), service, sizeof(service),
+                  NI_NUMERICHOST | NI_NUMERICSERV))  return string();
+
+  return string(host) + ":" + service;
+}
+
+//-----------------------------------------------------------------------------
+int udpSocketSyncIO::socketFD(asynUser *pasynUser)
+{
+  if (!pasynUser or !pasynUser->userPvt)  return -1;
+
+  return *static_cast<int *>(pasynUser->userPvt);
+}
+
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::waitReady(int fd, short events, double timeout)
+{
+  pollfd pfd { fd, events, 0 };
+
+  int ms = (timeout < 0.0) ? -1 : (int)(timeout * 1000.0 + 0.5);
+  int stat;
+  do  {
+    stat = poll(&pfd, 1, ms);
+  } while ((stat < 0) and (errno == EINTR));
+
+  if (stat < 0)  return asynError;
+  if (stat == 0)  return asynTimeout;
+  if (pfd.revents & (POLLERR | POLLNVAL))  return asynError;
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::write(asynUser *pasynUser, writeData outData,
+                                  size_t *nbytesOut, double timeout)
+{
+  size_t msgsOut;
+
+  *nbytesOut = 0;
+  asynStatus stat = writeMulti(pasynUser, &outData, 1, &msgsOut, timeout);
+  if (msgsOut)  *nbytesOut = outData.write_buffer_len;
+
+  return stat;
+}
+
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::read(asynUser *pasynUser, readData inData,
+                                 size_t *nbytesIn, double timeout,
+                                 int *eomReason)
+{
+  size_t msgsIn;
+
+  *nbytesIn = 0;
+  asynStatus stat = readMulti(pasynUser, &inData, nbytesIn, 1, &msgsIn,
+                              timeout);
+  if (eomReason)  *eomReason = msgsIn ? ASYN_EOM_END : 0;
+
+  return stat;
+}
+
+//-----------------------------------------------------------------------------
+//  Send the datagrams, up to MaxMsgsPerCall of them per sendmmsg() call
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::writeMulti(asynUser *pasynUser,
+                                       writeData outData[], size_t numMsgs,
+                                       size_t *msgsOut, double timeout)
+{
+  int fd = socketFD(pasynUser);
+
+  *msgsOut = 0;
+  if (fd < 0)  return asynDisconnected;
+
+  mmsghdr msgs[MaxMsgsPerCall];
+  iovec   iovs[MaxMsgsPerCall];
+
+  while (*msgsOut < numMsgs)  {
+    size_t batch = min(numMsgs - *msgsOut, MaxMsgsPerCall);
+
+    for (size_t u=0; u<batch; ++u)  {
+      writeData &msg = outData[*msgsOut + u];
+      iovs[u].iov_base = const_cast<char *>(msg.write_buffer);
+      iovs[u].iov_len = msg.write_buffer_len;
+      msgs[u] = mmsghdr {};
+      msgs[u].msg_hdr.msg_iov = &iovs[u];
+      msgs[u].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent = sendmmsg(fd, msgs, batch, MSG_DONTWAIT);
+    if (sent < 0)  {
+      if (errno == EINTR)  continue;
+      if ((errno != EAGAIN) and (errno != EWOULDBLOCK))  return asynError;
+      // socket buffer full: wait until there is room again
+      asynStatus stat = waitReady(fd, POLLOUT, timeout);
+      if (stat != asynSuccess)  return stat;
+      continue;
+    }
+
+    *msgsOut += sent;
+  }
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+//  Wait for the 1st datagram and then get as many as are already queued
+//  (up to maxMsgs) with a single recvmmsg() call
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::readMulti(asynUser *pasynUser, readData inData[],
+                                      size_t nbytesIn[], size_t maxMsgs,
+                                      size_t *msgsIn, double timeout)
+{
+  int fd = socketFD(pasynUser);
+
+  *msgsIn = 0;
+  if (fd < 0)  return asynDisconnected;
+  if (!maxMsgs)  return asynSuccess;
+
+  asynStatus stat = waitReady(fd, POLLIN, timeout);
+  if (stat != asynSuccess)  return stat;
+
+  size_t batch = min(maxMsgs, MaxMsgsPerCall);
+
+  mmsghdr msgs[MaxMsgsPerCall];
+  iovec   iovs[MaxMsgsPerCall];
+
+  for (size_t u=0; u<batch; ++u)  {
+    iovs[u].iov_base = inData[u].read_buffer;
+    iovs[u].iov_len = inData[u].read_buffer_len;
+    msgs[u] = mmsghdr {};
+    msgs[u].msg_hdr.msg_iov = &iovs[u];
+    msgs[u].msg_hdr.msg_iovlen = 1;
+  }
+
+  int rcvd;
+  do  {
+    rcvd = recvmmsg(fd, msgs, batch, MSG_DONTWAIT, nullptr);
+  } while ((rcvd < 0) and (errno == EINTR));
+
+  if (rcvd < 0)  {
+    if ((errno == EAGAIN) or (errno == EWOULDBLOCK))  return asynTimeout;
+    return asynError;
+  }
+
+  // a truncated datagram returns the # of bytes that fit in the buffer
+  for (int u=0; u<rcvd; ++u)  nbytesIn[u] = msgs[u].msg_len;
+  *msgsIn = rcvd;
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::writeRead(asynUser *pasynUser, writeData outData,
+                                      size_t *nbytesOut, readData inData,
+                                      size_t *nbytesIn, double timeout,
+                                      int *eomReason)
+{
+  asynStatus stat = write(pasynUser, outData, nbytesOut, timeout);
+  if (stat != asynSuccess)  return stat;
+
+  return read(pasynUser, inData, nbytesIn, timeout, eomReason);
+}
+
+//-----------------------------------------------------------------------------
+//  Discard any datagrams already queued for the socket
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::flush(asynUser *pasynUser)
+{
+  int fd = socketFD(pasynUser);
+  if (fd < 0)  return asynDisconnected;
+
+  char buf[1];
+  while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT | MSG_TRUNC) >= 0)  { }
+
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+//  UDP datagrams have no end-of-string processing
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::setInputEos(__attribute__((unused)) asynUser *pasynUser,
+                                        __attribute__((unused)) const char *eos,
+                                        int eoslen)
+{
+  return eoslen ? asynError : asynSuccess;
+}
+
+asynStatus udpSocketSyncIO::getInputEos(__attribute__((unused)) asynUser *pasynUser,
+                                        __attribute__((unused)) char *eos,
+                                        __attribute__((unused)) int eossize,
+                                        int *eoslen)
+{
+  *eoslen = 0;
+  return asynSuccess;
+}
+
+asynStatus udpSocketSyncIO::setOutputEos(__attribute__((unused)) asynUser *pasynUser,
+                                         __attribute__((unused)) const char *eos,
+                                         int eoslen)
+{
+  return eoslen ? asynError : asynSuccess;
+}
+
+asynStatus udpSocketSyncIO::getOutputEos(__attribute__((unused)) asynUser *pasynUser,
+                                         __attribute__((unused)) char *eos,
+                                         __attribute__((unused)) int eossize,
+                                         int *eoslen)
+{
+  *eoslen = 0;
+  return asynSuccess;
+}
+
+//-----------------------------------------------------------------------------
+//  The xxxOnce() funcs connect, do a single operation, and disconnect
+//-----------------------------------------------------------------------------
+asynStatus udpSocketSyncIO::writeOnce(const char *port, int addr,
+                                      writeData outData, size_t *nbytesOut,
+                                      double timeout, const char *drvInfo)
+{
+  asynUser *pasynUser;
+  asynStatus stat = connect(port, addr, &pasynUser, drvInfo);
+  if (stat != asynSuccess)  return stat;
+
+  stat = write(pasynUser, outData, nbytesOut, timeout);
+  disconnect(pasynUser);
+
+  return stat;
+}
+
+asynStatus udpSocketSyncIO::readOnce(const char *port, int addr,
+                                     readData inData, size_t *nbytesIn,
+                                     double timeout, int *eomReason,
+                                     const char *drvInfo)
+{
+  asynUser *pasynUser;
+  asynStatus stat = connect(port, addr, &pasynUser, drvInfo);
+  if (stat != asynSuccess)  return stat;
+
+  stat = read(pasynUser, inData, nbytesIn, timeout, eomReason);
+  disconnect(pasynUser);
+
+  return stat;
+}
+
+asynStatus udpSocketSyncIO::writeReadOnce(const char *port, int addr,
+                                          writeData outData, size_t *nbytesOut,
+                                          readData inData, size_t *nbytesIn,
+                                          double timeout, int *eomReason,
+                                          const char *drvInfo)
+{
+  asynUser *pasynUser;
+  asynStatus stat = connect(port, addr, &pasynUser, drvInfo);
+  if (stat != asynSuccess)  return stat;
+
+  stat = writeRead(pasynUser, outData, nbytesOut, inData, nbytesIn, timeout,
+                   eomReason);
+  disconnect(pasynUser);
+
+  return stat;
+}
+
+asynStatus udpSocketSyncIO::flushOnce(const char *port, int addr,
+                                      const char *drvInfo)
+{
+  asynUser *pasynUser;
+  asynStatus stat = connect(port, addr, &pasynUser, drvInfo);
+  if (stat != asynSuccess)  return stat;
+
+  stat = flush(pasynUser);
+  disconnect(pasynUser);
+
+  return stat;
+}
+
+asynStatus udpSocketSyncIO::setInputEosOnce(__attribute__((unused)) const char *port,
+                                            __attribute__((unused)) int addr,
+                                            const char *eos, int eoslen,
+                                            __attribute__((unused)) const char *drvInfo)
+{
+  return setInputEos(nullptr, eos, eoslen);
+}
+
+asynStatus udpSocketSyncIO::getInputEosOnce(__attribute__((unused)) const char *port,
+                                            __attribute__((unused)) int addr,
+                                            char *eos, int eossize, int *eoslen,
+                                            __attribute__((unused)) const char *drvInfo)
+{
+  return getInputEos(nullptr, eos, eossize, eoslen);
+}
+
+asynStatus udpSocketSyncIO::setOutputEosOnce(__attribute__((unused)) const char *port,
+                                             __attribute__((unused)) int addr,
+                                             const char *eos, int eoslen,
+                                             __attribute__((unused)) const char *drvInfo)
+{
+  return setOutputEos(nullptr, eos, eoslen);
+}
+
+asynStatus udpSocketSyncIO::getOutputEosOnce(__attribute__((unused)) const char *port,
+                                             __attribute__((unused)) int addr,
+                                             char *eos, int eossize,
+                                             int *eoslen,
+                                             __attribute__((unused)) const char *drvInfo)
+{
+  return getOutputEos(nullptr, eos, eossize, eoslen);
+}
@@ -0,0 +1,101 @@
+#ifndef UDPSOCKETSYNCIO_H
+#define UDPSOCKETSYNCIO_H
+
+/**
+ * @file  udpSocketSyncIO.h
+ * @brief asynOctetSyncIOInterface implementation that uses a kernel UDP socket
+ *        directly (bypassing the asyn port queueing and locking)
+ */
+
+#include <asynDriver.h>
+
+#include "asynOctetSyncIOInterface.h"
+
+/**
+ * @brief Implements asynOctetSyncIOInterface using a connected UDP socket.
+ *
+ * The "port" is the address of the device in the form {host}:{port} (i.e.
+ * the same as the hostInfo used for drvAsynIPPortConfigure, without the
+ * protocol).  writeMulti() and readMulti() use sendmmsg()/recvmmsg() to
+ * transfer several datagrams with one system call.
+ */
+class udpSocketSyncIO : public asynOctetSyncIOInterface {
+public:
+  asynStatus connect(const char *port, int addr, asynUser **ppasynUser,
+                     const char *drvInfo) override;
+  asynStatus disconnect(asynUser *pasynUser) override;
+  asynStatus connectShared(const char *port, int addr, asynUser *pasynUser,
+                           asynUser **ppasynUser, const char *drvInfo)
+      override;
+  std::string peerAddr(asynUser *pasynUser) override;
+  asynStatus write(asynUser *pasynUser, writeData outData, size_t *nbytesOut,
+                   double timeout) override;
+  asynStatus read(asynUser *pasynUser, readData inData, size_t *nbytesIn,
+                  double timeout, int *eomReason) override;
+  asynStatus writeRead(asynUser *pasynUser, writeData outData,
+                       size_t *nbytesOut, readData inData, size_t *nbytesIn,
+                       double timeout, int *eomReason) override;
+  asynStatus flush(asynUser *pasynUser) override;
+  asynStatus setInputEos(asynUser *pasynUser, const char *eos, int eoslen)
+      override;
+  asynStatus getInputEos(asynUser *pasynUser, char *eos, int eossize,
+                         int *eoslen) override;
+  asynStatus setOutputEos(asynUser *pasynUser, const char *eos, int eoslen)
+      override;
+  asynStatus getOutputEos(asynUser *pasynUser, char *eos, int eossize,
+                          int *eoslen) override;
+  asynStatus writeOnce(const char *port, int addr, writeData outData,
+                       size_t *nbytesOut, double timeout, const char *drvInfo)
+      override;
+  asynStatus readOnce(const char *port, int addr, readData inData,
+                      size_t *nbytesIn, double timeout, int *eomReason,
+                      const char *drvInfo) override;
+  asynStatus writeReadOnce(const char *port, int addr, writeData outData,
+                           size_t *nbytesOut, readData inData, size_t *nbytesIn,
+                           double timeout, int *eomReason, const char *drvInfo)
+      override;
+  asynStatus flushOnce(const char *port, int addr, const char *drvInfo)
+      override;
+  asynStatus setInputEosOnce(const char *port, int addr, const char *eos,
+                             int eoslen, const char *drvInfo) override;
+  asynStatus getInputEosOnce(const char *port, int addr, char *eos,
+                             int eossize, int *eoslen, const char *drvInfo)
+      override;
+  asynStatus setOutputEosOnce(const char *port, int addr, const char *eos,
+                              int eoslen, const char *drvInfo) override;
+  asynStatus getOutputEosOnce(const char *port, int addr, char *eos,
+                              int eossize, int *eoslen, const char *drvInfo)
+      override;
+
+  asynStatus writeMulti(asynUser *pasynUser, writeData outData[],
+                        size_t numMsgs, size_t *msgsOut, double timeout)
+      override;
+  asynStatus readMulti(asynUser *pasynUser, readData inData[],
+                       size_t nbytesIn[], size_t maxMsgs, size_t *msgsIn,
+                       double timeout) override;
+
+private:
+  /**
+   * @brief Method that returns the socket for a connection
+   *
+   * @param[in] pasynUser asynUser returned by connect()
+   *
+   * @return socket file descriptor or -1 if not connected
+   */
+  static int socketFD(asynUser *pasynUser);
+
+  /**
+   * @brief Method that waits until the socket is ready for I/O
+   *
+   * @param[in] fd      socket file descriptor
+   * @param[in] events  POLLIN or POLLOUT
+   * @param[in] timeout max # of secs to wait
+   *
+   * @return asynSuccess, asynTimeout or asynError
+   */
+  static asynStatus waitReady(int fd, short events, double timeout);
+
+  static const size_t MaxMsgsPerCall = 64;  //!< Max # of datagrams per sendmmsg()/recvmmsg() call
+};
+
+#endif // UDPSOCKETSYNCIO_H
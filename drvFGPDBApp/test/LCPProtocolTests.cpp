@@ -1,3 +1,7 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+
 #include "gmock/gmock.h"
 
 #include "LCPProtocol.h"
@@ -35,3 +39,112 @@ TEST_F(sessionID, canBeReadOutAgain) {
 
   ASSERT_THAT(aSessionId, Eq(rereadSessionId));
 }
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The vectorized compares (the one picked for this CPU and each one
+ *        the CPU supports) flag the same regs as the scalar one, for any
+ *        count and for changes at any position
+ */
+TEST(findChangedRegs, matchesScalarVersion) {
+  using FindFn = size_t (*)(const uint32_t *, const uint32_t *, size_t,
+                            uint64_t *);
+  std::vector<FindFn> findFns { LCPUtil::findChangedRegs };
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("avx2"))  findFns.push_back(LCPUtil::findChangedRegsAVX2);
+  if (__builtin_cpu_supports("sse2"))  findFns.push_back(LCPUtil::findChangedRegsSSE2);
+#endif
+  std::mt19937 randGen(1);
+
+  for (size_t count : { 1u, 3u, 4u, 7u, 8u, 63u, 64u, 65u, 130u, 1000u })  {
+    std::vector<uint32_t> shadow(count), resp(count);
+    for (auto &val : shadow)  val = randGen();
+    resp = shadow;
+    for (size_t u=0; u<count; u+=1+randGen()%5)  resp[u] ^= 1u << (randGen()%32);
+
+    std::vector<uint64_t> scalarBits((count + 63) / 64, ~0ull);
+    size_t scalarNumChgd = LCPUtil::findChangedRegsScalar(
+        resp.data(), shadow.data(), count, scalarBits.data());
+
+    for (auto findFn : findFns)  {
+      std::vector<uint64_t> bits((count + 63) / 64, ~0ull);
+      size_t numChgd = findFn(resp.data(), shadow.data(), count, bits.data());
+
+      ASSERT_THAT(numChgd, Eq(scalarNumChgd));
+      ASSERT_THAT(bits, ContainerEq(scalarBits));
+      for (size_t u=0; u<count; ++u)
+        ASSERT_THAT((bits[u / 64] >> (u % 64)) & 1, Eq(resp[u] != shadow[u]));
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief crc32c() gives the standard CRC-32C check value, and the SSE4.2
+ *        version (if the CPU has it) matches the scalar one for any length,
+ *        alignment and split of the bytes
+ */
+TEST(crc32c, matchesCheckValueAndScalarVersion) {
+  const std::string checkStr("123456789");
+  const uint8_t *checkBytes = reinterpret_cast<const uint8_t *>(checkStr.data());
+  ASSERT_THAT(LCPUtil::crc32c(checkBytes, checkStr.size()), Eq(0xE3069283u));
+  ASSERT_THAT(LCPUtil::crc32cScalar(checkBytes, checkStr.size()), Eq(0xE3069283u));
+  ASSERT_THAT(LCPUtil::crc32c(checkBytes + 4, 5, LCPUtil::crc32c(checkBytes, 4)),
+              Eq(0xE3069283u));
+
+  std::mt19937 randGen(1);
+  std::vector<uint8_t> bytes(300);
+  for (auto &byte : bytes)  byte = randGen();
+
+  for (size_t first : { 0u, 1u, 3u })
+    for (size_t count : { 0u, 1u, 7u, 8u, 9u, 64u, 255u, 256u })  {
+      uint32_t scalarCRC = LCPUtil::crc32cScalar(bytes.data() + first, count);
+      ASSERT_THAT(LCPUtil::crc32c(bytes.data() + first, count), Eq(scalarCRC));
+#if defined(__x86_64__)
+      if (__builtin_cpu_supports("sse4.2"))  {
+        ASSERT_THAT(LCPUtil::crc32cSSE42(bytes.data() + first, count, 0),
+                    Eq(scalarCRC));
+      }
+#endif
+    }
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Micro-benchmark for a 1k-register group with 1% of the regs changed
+ *        (the results are printed, only the # of changes is checked).  Run
+ *        with --gtest_also_run_disabled_tests.
+ */
+TEST(findChangedRegs, DISABLED_benchmark1kRegGroup) {
+  const size_t count = 1000, numCycles = 20000;
+  std::vector<uint32_t> shadow(count, htonl(5)), resp(shadow);
+  std::vector<uint64_t> bits((count + 63) / 64);
+  for (size_t u=0; u<count; u+=100)  resp[u] = htonl(6);
+
+  size_t ttlChgd = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t cycle=0; cycle<numCycles; ++cycle)  {
+    resp[cycle % count] ^= htonl(0x100);
+    ttlChgd += LCPUtil::findChangedRegs(resp.data(), shadow.data(), count,
+                                        bits.data());
+    resp[cycle % count] ^= htonl(0x100);
+  }
+  std::chrono::duration<double> vecTime = std::chrono::steady_clock::now() - start;
+
+  size_t ttlScalarChgd = 0;
+  start = std::chrono::steady_clock::now();
+  for (size_t cycle=0; cycle<numCycles; ++cycle)  {
+    resp[cycle % count] ^= htonl(0x100);
+    ttlScalarChgd += LCPUtil::findChangedRegsScalar(resp.data(), shadow.data(),
+                                                    count, bits.data());
+    resp[cycle % count] ^= htonl(0x100);
+  }
+  std::chrono::duration<double> scalarTime = std::chrono::steady_clock::now() - start;
+
+  ASSERT_THAT(ttlChgd, Eq(ttlScalarChgd));
+
+  std::cout << "scalar:     " << scalarTime.count() / numCycles * 1e9
+            << " nsecs/response" << std::endl;
+  std::cout << "vectorized: " << vecTime.count() / numCycles * 1e9
+            << " nsecs/response" << std::endl;
+}
@@ -42,6 +42,113 @@ TEST(ParamInfo, constructsNewParamFromDefinitionString)  {
   ASSERT_THAT(stream.str(), Eq("lcpRegRO_1 0x10002 Int32 U32"));
 }
 
+//-----------------------------------------------------------------------------
+TEST(ParamInfo, constructsWaveformParamFromDefinitionString)  {
+  ParamInfo param("cavAmpWF 0x1 WF 3 1000 Float64Array F32");
+
+  ASSERT_THAT(param.isWaveformParam(), Eq(true));
+  ASSERT_THAT(param.isArrayParam(), Eq(false));
+  ASSERT_THAT(param.isReadOnly(), Eq(true));
+  ASSERT_THAT(param.getWaveformID(), Eq(3u));
+  ASSERT_THAT(param.wfValRead.size(), Eq(1000u));
+  ASSERT_THAT(param.wfFloat64.size(), Eq(1000u));
+
+  ostringstream stream;
+  stream << param;
+  ASSERT_THAT(stream.str(), Eq("cavAmpWF 0x1 WF 3 1000 Float64Array F32"));
+}
+
+//-----------------------------------------------------------------------------
+TEST(ParamInfo, constructsParamWithReadingFiltersFromDefinitionString)  {
+  ParamInfo param("cavAmp 0x10002 Float64 F32 ADEL=0.5 RDEL=0.01 MINT=100");
+
+  ASSERT_THAT(param.getAbsDeadband(), DoubleEq(0.5));
+  ASSERT_THAT(param.getRelDeadband(), DoubleEq(0.01));
+  ASSERT_THAT(param.getMinPostInterval(), Eq(100u));
+
+  ostringstream stream;
+  stream << param;
+  ASSERT_THAT(stream.str(),
+              Eq("cavAmp 0x10002 Float64 F32 ADEL=0.5 RDEL=0.01 MINT=100"));
+
+  ParamInfo slowParam("fwVersion 0x10001 Int32 U32 SCAN=0.1Hz");
+  ASSERT_THAT(slowParam.getScanClass(), Eq(ScanClass::Hz0_1));
+
+  stream.str("");
+  stream << slowParam;
+  ASSERT_THAT(stream.str(), Eq("fwVersion 0x10001 Int32 U32 SCAN=0.1Hz"));
+
+  ASSERT_ANY_THROW(ParamInfo("cavAmp 0x10002 Float64 ADEL=0.5"));
+  ASSERT_ANY_THROW(ParamInfo("fwVersion 0x10001 Int32 U32 SCAN=0x1Hz"));
+  ASSERT_ANY_THROW(ParamInfo("cavAmp 0x10002 Float64 F32 MINT=0.5"));
+}
+
+//-----------------------------------------------------------------------------
+TEST(ParamInfo, filtersReadingsWithinDeadbandsOrMinInterval)  {
+  ParamInfo param("cavAmp 0x10002 Float64 U16_16 ADEL=0.5 RDEL=0.1 MINT=100");
+  auto ctlrVal = [](double val) {
+    return ParamInfo::doubleToCtlrFmt(val, CtlrDataFmt::U16_16); };
+  auto readTime = chrono::steady_clock::now();
+
+  ASSERT_TRUE(param.passesReadingFilter(ctlrVal(10.0), readTime));  // 1st one
+  param.newReadVal(ctlrVal(10.0));
+  ASSERT_TRUE(param.passesReadingFilter(ctlrVal(10.2), readTime));  // not posted
+
+  param.readState = ReadState::Current;
+  auto now = chrono::steady_clock::now() + chrono::milliseconds(100);
+
+  ASSERT_FALSE(param.passesReadingFilter(ctlrVal(10.4), now));  // ADEL
+  ASSERT_FALSE(param.passesReadingFilter(ctlrVal(10.9), now));  // RDEL
+  ASSERT_TRUE(param.passesReadingFilter(ctlrVal(11.5), now));
+  ASSERT_TRUE(param.passesReadingFilter(ctlrVal(8.5), now));
+
+  now = readTime + chrono::milliseconds(99);
+  ASSERT_FALSE(param.passesReadingFilter(ctlrVal(11.5), now));  // MINT
+}
+
+//-----------------------------------------------------------------------------
+TEST(ParamInfo, acceptsOptionalReadRateParamForArray)  {
+  ParamInfo param("pmemTest 0x2 1 256 N 0x80 0x400 rdStatus wrStatus");
+  ASSERT_TRUE(param.rdRateParamName.empty());
+
+  ParamInfo rateParam("pmemTest 0x2 1 256 N 0x80 0x400 rdStatus wrStatus rdRate");
+  ASSERT_THAT(rateParam.rdRateParamName, Eq("rdRate"));
+  ASSERT_THAT(rateParam.wrStatusParamName, Eq("wrStatus"));
+
+  stringstream defStr;
+  defStr << rateParam;
+  ASSERT_THAT(defStr.str(), HasSubstr("rdStatus wrStatus rdRate"));
+}
+
+//-----------------------------------------------------------------------------
+TEST(ParamInfo, findsBlocksChangedByNewArrayValue)  {
+  ParamInfo param("pmemTest 0x2 1 256 N 0x80 0x400 rdStatus wrStatus");
+  param.readState = ReadState::Current;  // arrayValRead is all 0s
+  param.arrayValSet = param.arrayValRead;
+  param.arrayValSet.at(0x200) = 1;  // block 2
+  param.arrayValSet.at(0x3FF) = 1;  // block 4 (the partial last one)
+
+  param.initBlockRW(param.arrayValSet.size());
+  param.findChgdBlocks();
+  param.setState = SetState::Pending;
+  ASSERT_THAT(param.getWorkSize(), Eq(256u + 128u));
+
+  vector<bool> chgd;
+  while (param.getBytesLeft())  {
+    chgd.push_back(param.blockChgd());
+    param.advanceBlock();
+  }
+  ASSERT_THAT(chgd, ElementsAre(false, false, true, false, true));
+  ASSERT_THAT(param.getWorkLeft(), Eq(0u));
+
+  // without a complete read value every block is written
+  param.readState = ReadState::Update;
+  param.initBlockRW(param.arrayValSet.size());
+  param.findChgdBlocks();
+  ASSERT_THAT(param.getWorkSize(), Eq(0x400u));
+  ASSERT_TRUE(param.blockChgd());
+}
+
 //-----------------------------------------------------------------------------
 TEST(ParamInfo, ctorFailsIfParamDefinitionStringEmpty)  {
   ASSERT_ANY_THROW(ParamInfo param(""));
@@ -5,6 +5,8 @@
           on the same machine.
  */
 #include <memory>
+#include <chrono>
+#include <iostream>
 
 #include "gmock/gmock.h"
 
@@ -13,6 +15,7 @@
 #include "LCPProtocol.h"
 #include "drvAsynIPPort.h"
 #include "asynOctetSyncIOWrapper.h"
+#include "udpSocketSyncIO.h"
 #include "drvFGPDBTestCommon.h"
 
 #include <lcpsimulatorClass.hpp>
@@ -20,3 +23,74 @@
 
 const std::string localIPAddr="0.0.0.0";
 const unsigned short localPort=2005;
+
+/**
+ * @brief Sends READ_REGS cmds to the simulator, batchSize at a time, and waits
+ *        for all the responses
+ *
+ * @param[in] syncIO    transport to use
+ * @param[in] port      asyn port name or {host}:{port} (depending on syncIO)
+ * @param[in] numCmds   total # of cmds to send
+ * @param[in] batchSize # of cmds sent before waiting for their responses
+ *
+ * @return # of secs it took or -1 if not all of the responses were received
+ */
+static double timeRoundTrips(asynOctetSyncIOInterface &syncIO, const char *port,
+                             int numCmds, int batchSize)
+{
+  asynUser *pasynUser = nullptr;
+  if (syncIO.connect(port, 0, &pasynUser, nullptr) != asynSuccess)  return -1;
+
+  vector<LCPReadRegs> cmds(batchSize, LCPReadRegs(0x10000, 8, 0));
+  vector<writeData> outData(batchSize);
+  vector<vector<uint32_t>> respBufs(batchSize, vector<uint32_t>(64));
+  vector<readData> inData(batchSize);
+  vector<size_t> nbytesIn(batchSize);
+  int respsRcvd = 0;
+
+  auto start = chrono::steady_clock::now();
+
+  for (int sent = 0; sent < numCmds; sent += batchSize)  {
+    for (int u=0; u<batchSize; ++u)  {
+      cmds[u].setCmdPktID(sent + u);
+      outData[u] = { (const char *)cmds[u].getCmdBuf().data(),
+                     cmds[u].getCmdBuf().size() * sizeof(uint32_t) };
+      inData[u] = { (char *)respBufs[u].data(),
+                    respBufs[u].size() * sizeof(uint32_t) };
+    }
+    size_t msgs = 0;
+    syncIO.writeMulti(pasynUser, outData.data(), batchSize, &msgs, 1.0);
+    for (int rcvd = 0; rcvd < batchSize; rcvd += msgs)  {
+      if (syncIO.readMulti(pasynUser, inData.data() + rcvd, nbytesIn.data() + rcvd,
+                           batchSize - rcvd, &msgs, 1.0) != asynSuccess)  break;
+      respsRcvd += msgs;
+    }
+  }
+
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+  syncIO.disconnect(pasynUser);
+
+  return (respsRcvd == numCmds) ? elapsed.count() : -1;
+}
+
+/**
+ * @brief Compares the asyn and native socket transports (the results are
+ *        printed, only the responses are checked)
+ */
+TEST(ASyncIOTransport, benchmarkAsynVsSocket) {
+  const int numCmds = 20000, batchSize = 8;
+  ASSERT_THAT(createPortUDP(), Eq(asynSuccess));
+
+  asynOctetSyncIOWrapper asynIO;
+  udpSocketSyncIO socketIO;
+
+  double asynSecs = timeRoundTrips(asynIO, UDPPortName.c_str(), numCmds, batchSize);
+  double socketSecs = timeRoundTrips(socketIO, "127.0.0.1:2005", numCmds, batchSize);
+
+  cout << "asyn:   " << numCmds / asynSecs << " cmds/sec" << endl;
+  cout << "socket: " << numCmds / socketSecs << " cmds/sec" << endl;
+
+  ASSERT_THAT(asynSecs, Gt(0.0));
+  ASSERT_THAT(socketSecs, Gt(0.0));
+}
@@ -4,6 +4,19 @@
  */
 
 #include <memory>
+#include <deque>
+#include <map>
+#include <atomic>
+#include <future>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <alarm.h>
 
 #include "gmock/gmock.h"
 
@@ -11,6 +24,7 @@
 #include "drvFGPDB.h"
 #include "drvAsynIPPort.h"
 #include "asynOctetSyncIOInterface.h"
+#include "udpSocketSyncIO.h"
 #include "drvFGPDBTestCommon.h"
 #include "streamLogger.h"
 
@@ -73,9 +87,9 @@ public:
     AnFGPDBDriver(make_shared<asynOctetSyncIOWrapperMock>())
   {
     EXPECT_CALL(*static_pointer_cast<asynOctetSyncIOWrapperMock>(syncIO),
-                connect(_, _, _, _)).WillOnce(Return(asynSuccess));
+                connect(_, _, _, _)).Times(2).WillRepeatedly(Return(asynSuccess));
     EXPECT_CALL(*static_pointer_cast<asynOctetSyncIOWrapperMock>(syncIO),
-                disconnect(_)).WillOnce(Return(asynSuccess));
+                disconnect(_)).Times(2).WillRepeatedly(Return(asynSuccess));
     testDrv = make_unique<drvFGPDB>(drvName, syncIO, UDPPortName,
                                     startupDiagFlags,
                                     ResendMode::AfterCtlrRestart, pLog);
@@ -91,8 +105,160 @@ public:
 
   static asynStatus read_mock_helper(Unused, readData inData, size_t *nbytesIn,
                                      Unused, Unused);
+
+  //! Builds the response the mock ctlr sends for a cmd
+  using RespFn = function<vector<uint32_t> (const vector<uint32_t> &cmd)>;
+  //! Returns the # of responses the mock ctlr sends for a cmd (0 if it is lost)
+  using SendFn = function<int (const vector<uint32_t> &cmd)>;
+
+  /**
+   * @brief Method that makes the syncIO mock act as the ctlr: each cmd
+   *        written is queued in sentCmds and each read returns the response
+   *        for the oldest queued cmd (or times out if there is none)
+   *
+   * @param[in] respFn builds the response for a cmd
+   * @param[in] onSend if set, called for each cmd written (see SendFn)
+   */
+  void recordCmdsAndEcho(RespFn respFn, SendFn onSend = nullptr);
+
+  /**
+   * @brief Response with the packet ID and cmd of a cmd and 0s for the rest
+   *
+   * @param[in] cmd      cmd the response is for
+   * @param[in] numWords # of words in the response
+   */
+  static vector<uint32_t> echoHdr(const vector<uint32_t> &cmd, size_t numWords);
+
+  /**
+   * @brief Response to a READ_REGS cmd with the same value for each reg
+   *
+   * @param[in] cmd    READ_REGS cmd the response is for
+   * @param[in] regVal value (in network byte order) returned for each reg
+   */
+  static vector<uint32_t> readRegsResp(const vector<uint32_t> &cmd,
+                                       uint32_t regVal = 0);
+
+  /**
+   * @brief Value of the byte at a PMEM addr in the mock ctlr's chip
+   */
+  static uint8_t chipByte(uint32_t addr) { return uint8_t(addr * 7 + (addr >> 8)); }
+
+  /**
+   * @brief Method that primes the RTT estimates with a short RTT, so that
+   *        the retransmit timeouts of the tests are quick
+   */
+  void useShortRTTs() {
+    for (int u=0; u<20; ++u)  {
+      testDrv->regRTTEst.addSample(0.001);  testDrv->blockRTTEst.addSample(0.001); }
+  }
+
+  /**
+   * @brief Method that writes a new value to an array param the way an asyn
+   *        client does (i.e. with the asyn lock held)
+   *
+   * @param[in] paramID ID of the array param
+   * @param[in] newVal  new value
+   *
+   * @return status returned by writeInt8Array()
+   */
+  asynStatus clientWriteInt8Array(int paramID, vector<epicsInt8> newVal) {
+    lock_guard<drvFGPDB> asynLock(*testDrv);  // as the asyn layer does
+    pasynUser->reason = paramID;
+    return testDrv->writeInt8Array(pasynUser, newVal.data(), newVal.size());
+  }
+
+  /**
+   * @brief # of LCP reg params whose setState or ctlrValSet differs from the
+   *        shadow in their ProcGroup (i.e. that were changed without going
+   *        through updateSetting())
+   */
+  size_t settingsOutOfSync();
+
+  /**
+   * @brief Word 2 of a response that keeps the driver's write access
+   *
+   * @param[in] respStatus LCPStatus returned for the cmd
+   */
+  uint32_t sessionWord(uint32_t respStatus = 0) {
+    return htonl((uint32_t(testDrv->sessionID.get()) << 16) | respStatus); }
+
+  mutex  sentCmdsLock;                //!< protects sentCmds and sentBufs
+  deque<vector<uint32_t>>  sentCmds;  //!< cmds the mock ctlr has not answered yet
+  vector<const char *>  sentBufs;     //!< buffer each cmd was written from
 };
 
+//-----------------------------------------------------------------------------
+void AnFGPDBDriverUsingIOSyncMock::recordCmdsAndEcho(RespFn respFn,
+                                                     SendFn onSend)
+{
+  auto syncIOMock = static_pointer_cast<asynOctetSyncIOWrapperMock>(syncIO);
+
+  EXPECT_CALL(*syncIOMock, write(_, _, _, _)).WillRepeatedly(Invoke(
+    [this, onSend](Unused, writeData outData, size_t *nbytesOut, Unused) {
+      auto words = reinterpret_cast<const uint32_t *>(outData.write_buffer);
+      vector<uint32_t> cmd(words, words + outData.write_buffer_len / 4);
+      lock_guard<mutex> lock(sentCmdsLock);
+      sentBufs.push_back(outData.write_buffer);
+      for (int n = onSend ? onSend(cmd) : 1; n > 0; --n)  sentCmds.push_back(cmd);
+      *nbytesOut = outData.write_buffer_len;
+      return asynSuccess;
+    }));
+  EXPECT_CALL(*syncIOMock, read(_, _, _, _, _)).WillRepeatedly(Invoke(
+    [this, respFn](Unused, readData inData, size_t *nbytesIn, Unused, Unused) {
+      *nbytesIn = 0;
+      vector<uint32_t> cmd;
+      {
+        lock_guard<mutex> lock(sentCmdsLock);
+        if (!sentCmds.empty())  {
+          cmd = move(sentCmds.front());  sentCmds.pop_front(); }
+      }
+      // (waits a bit, as a real read would, so the receiver thread doesn't spin)
+      if (cmd.empty())  { this_thread::sleep_for(1ms);  return asynTimeout; }
+      vector<uint32_t> resp = respFn(cmd);
+      *nbytesIn = min(resp.size() * sizeof(resp[0]), inData.read_buffer_len);
+      memcpy(inData.read_buffer, resp.data(), *nbytesIn);
+      return asynSuccess;
+    }));
+}
+
+//-----------------------------------------------------------------------------
+vector<uint32_t> AnFGPDBDriverUsingIOSyncMock::echoHdr(
+    const vector<uint32_t> &cmd, size_t numWords)
+{
+  vector<uint32_t> resp(numWords, 0);
+  copy_n(cmd.begin(), 2, resp.begin());
+  return resp;
+}
+
+//-----------------------------------------------------------------------------
+vector<uint32_t> AnFGPDBDriverUsingIOSyncMock::readRegsResp(
+    const vector<uint32_t> &cmd, uint32_t regVal)
+{
+  vector<uint32_t> resp(5 + ntohl(cmd[3]), regVal);
+  copy_n(cmd.begin(), 4, resp.begin());
+  return resp;
+}
+
+//-----------------------------------------------------------------------------
+size_t AnFGPDBDriverUsingIOSyncMock::settingsOutOfSync()
+{
+  lock_guard<drvFGPDB> asynLock(*testDrv);
+
+  size_t numOutOfSync = 0;
+  for (auto groupID : { ProcGroup_LCP_RO, ProcGroup_LCP_WA, ProcGroup_LCP_WO })  {
+    const ProcGroup &group = testDrv->getProcGroup(groupID);
+    for (size_t offset=0; offset<group.paramIDs.size(); ++offset)  {
+      if (!testDrv->validParamID(group.paramIDs[offset]))  continue;
+      const ParamInfo &param = testDrv->params.at(group.paramIDs[offset]);
+      if ((group.setVals.at(offset) != param.ctlrValSet) or
+          (group.setStates.at(offset) != static_cast<uint8_t>(param.setState)))
+        ++numOutOfSync;
+    }
+  }
+
+  return numOutOfSync;
+}
+
 //-----------------------------------------------------------------------------
 /**
  * @brief UDP/IP connection is configured successfully
@@ -401,3 +567,1312 @@ TEST_F(AnFGPDBDriverUsingIOSyncMock, detectsTrunkatedMsgFromAsyn) {
 
   ASSERT_THAT(bytesRead, Eq(respBuf.size() * sizeof(respBuf[0])));
 }
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Up to maxPktsInFlight cmds are sent before waiting for a response
+ *        and each response is matched to its cmd by packet ID
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, keepsMultipleCmdsInFlight) {
+  size_t maxOutstanding = 0;
+
+  recordCmdsAndEcho(
+    [] (const vector<uint32_t> &cmd) { return echoHdr(cmd, 5); },
+    [&] (Unused) {
+      maxOutstanding = max(maxOutstanding, sentCmds.size() + 1);  return 1; });
+
+  LCPReadRegs readRO(0x10000, 0, 0), readWA(0x20000, 0, 0), readWO(0x30000, 0, 0);
+  LCPCmdBase * const LCPCmds[] = { &readRO, &readWA, &readWO };
+
+  testDrv->maxPktsInFlight = 2;
+  stat = testDrv->sendCmdsGetResps(pasynUser, LCPCmds, 3);
+
+  ASSERT_THAT(stat, Eq(asynSuccess));
+  ASSERT_THAT(maxOutstanding, Eq(2u));
+  ASSERT_TRUE(readRO.respRcvd() and readWA.respRcvd() and readWO.respRcvd());
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The packet IDs of sync cmds wrap before they reach AsyncPktIDFlag
+ *        (and skip 0), so their responses are never routed to the stream
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, wrapsSyncPktIDBelowAsyncPktIDFlag) {
+  vector<uint32_t> sentPktIDs;
+
+  recordCmdsAndEcho(
+    [] (const vector<uint32_t> &cmd) { return echoHdr(cmd, 5); },
+    [&] (const vector<uint32_t> &cmd) {
+      sentPktIDs.push_back(ntohl(cmd[0]));  return 1; });
+
+  LCPReadRegs readRO(0x10000, 0, 0), readWA(0x20000, 0, 0), readWO(0x30000, 0, 0);
+  LCPCmdBase * const LCPCmds[] = { &readRO, &readWA, &readWO };
+
+  testDrv->syncPktID = drvFGPDB::AsyncPktIDFlag - 2;
+  stat = testDrv->sendCmdsGetResps(pasynUser, LCPCmds, 3);
+
+  ASSERT_THAT(stat, Eq(asynSuccess));
+  ASSERT_TRUE(readRO.respRcvd() and readWA.respRcvd() and readWO.respRcvd());
+  ASSERT_THAT(sentPktIDs, ElementsAre(drvFGPDB::AsyncPktIDFlag - 1, 1u, 2u));
+  ASSERT_THAT(testDrv->syncPktID, Eq(2u));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The READ_REGS cmds of the poll plan are built once and reused for
+ *        each cycle (with a new packet ID), until the group sizes change
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, reusesPollPlanForEachCycle) {
+  recordCmdsAndEcho([] (const vector<uint32_t> &cmd) { return readRegsResp(cmd); });
+
+  addParams();
+
+  testDrv->buildPollPlan();
+  ASSERT_TRUE(testDrv->pollPlanValid());
+
+  testDrv->updateScalarReadValues();
+  testDrv->updateScalarReadValues();
+
+  ASSERT_THAT(sentBufs.size(), Eq(6u));
+  for (int u=0; u<3; ++u)  {
+    ASSERT_THAT(sentBufs.at(u + 3), Eq(sentBufs.at(u)));
+    ASSERT_TRUE(testDrv->pollPlans[0].readCmds.at(u).respRcvd());
+  }
+  ASSERT_THAT(testDrv->pollPlans[0].readCmds.at(0).getCmdPktID(), Eq(4u));
+
+  addParam("lcpRegRO_9 0x10009 Int32 U32");
+  ASSERT_FALSE(testDrv->pollPlanValid());
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The poll plan skips the large gaps in each group (but not the small
+ *        ones) and splits the groups that don't fit in one datagram
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, plansReadsAroundGapsAndWithinMTU) {
+  auto ranges = [&]() {
+    vector<pair<uint32_t, uint32_t>> planned;
+    for (auto &readCmd : testDrv->pollPlans[0].readCmds)
+      planned.emplace_back(readCmd.getOffset(), readCmd.getCount());
+    return planned;
+  };
+  addParams();
+
+  testDrv->buildPollPlan();
+  ASSERT_THAT(ranges(), ElementsAre(Pair(0x10002u, 4u), Pair(0x20000u, 5u),
+                                    Pair(0x300FFu, 1u)));
+  ASSERT_THAT(testDrv->pollPlans[0].numROCmds, Eq(1u));
+
+  addParam("lcpRegRO_20 0x10014 Int32 U32");  // gap of 14 regs
+  addParam("lcpRegRO_80 0x10080 Int32 U32");  // gap of 107 regs
+  ASSERT_FALSE(testDrv->pollPlanValid());
+
+  testDrv->buildPollPlan();
+  ASSERT_THAT(ranges(), ElementsAre(Pair(0x10002u, 19u), Pair(0x10080u, 1u),
+                                    Pair(0x20000u, 5u), Pair(0x300FFu, 1u)));
+  ASSERT_THAT(testDrv->pollPlans[0].numROCmds, Eq(2u));
+
+  testDrv->etherMTU = drvFGPDB::ReadRegsPktOverhead + 3 * 4;
+  ASSERT_FALSE(testDrv->pollPlanValid());
+
+  testDrv->buildPollPlan();
+  ASSERT_THAT(ranges(), ElementsAre(Pair(0x10002u, 1u), Pair(0x10004u, 2u),
+                                    Pair(0x10014u, 1u), Pair(0x10080u, 1u),
+                                    Pair(0x20000u, 1u), Pair(0x20002u, 3u),
+                                    Pair(0x300FFu, 1u)));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Each scan class has its own READ_REGS ranges and only its regs are
+ *        read when it is updated
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, readsEachScanClassWithItsOwnCmds) {
+  vector<pair<uint32_t, uint32_t>> ranges;
+
+  recordCmdsAndEcho(
+    [] (const vector<uint32_t> &cmd) { return readRegsResp(cmd, htonl(3)); },
+    [&] (const vector<uint32_t> &cmd) {
+      ranges.emplace_back(ntohl(cmd[2]), ntohl(cmd[3]));  return 1; });
+
+  addParams();
+  int fastID = addParam("lcpRegRO_3 0x10003 Float64 F32 SCAN=10Hz");
+  int slowID = addParam("lcpRegWA_5 0x20005 Int32 U32 SCAN=0.1Hz");
+  ASSERT_THAT(addParam("lcpRegWA_5 0x20005 Int32 U32 SCAN=1Hz"), Eq(-1));
+
+  testDrv->updateScalarReadValues(ScanClass::Hz10);
+  ASSERT_THAT(ranges, ElementsAre(Pair(0x10003u, 1u)));
+  ASSERT_THAT(testDrv->getParamInfo(fastID).ctlrValRead, Eq(3u));
+  ASSERT_THAT(testDrv->getParamInfo(testParamID_RO).readState,
+              Eq(ReadState::Undefined));
+
+  ranges.clear();
+  testDrv->updateScalarReadValues(ScanClass::Hz1);
+  ASSERT_THAT(ranges, IsEmpty());
+
+  testDrv->updateScalarReadValues(ScanClass::Hz0_1);
+  ASSERT_THAT(ranges, ElementsAre(Pair(0x20005u, 1u)));
+  ASSERT_THAT(testDrv->getParamInfo(slowID).ctlrValRead, Eq(3u));
+
+  // (reading the 10Hz reg in the RO range costs less than an extra cmd)
+  ranges.clear();
+  testDrv->updateScalarReadValues();
+  ASSERT_THAT(ranges, ElementsAre(Pair(0x10002u, 4u), Pair(0x20000u, 5u),
+                                  Pair(0x300FFu, 1u)));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The regs in the named scan classes are read with the Default ones
+ *        until the ctlr is online, so they don't stop it from coming online
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, comesOnlineWithRegsInNamedScanClasses) {
+  recordCmdsAndEcho(
+    [] (const vector<uint32_t> &cmd) { return readRegsResp(cmd, htonl(3)); });
+
+  addParams();
+  // far from the other RO regs, so the Default reads don't cover it
+  int slowID = addParam("lcpRegRO_40 0x10040 Int32 U32 SCAN=1Hz");
+  ASSERT_THAT(slowID, Ge(0));
+
+  // (the 1st upSecs read is taken as a ctlr restart, which resets all the
+  // read states, so it takes 2 poll cycles)
+  for (int u=0; u<2; ++u)  {
+    testDrv->processScalarReads();
+    testDrv->postNewReadings();
+    testDrv->checkComStatus();
+  }
+
+  ASSERT_THAT(testDrv->getParamInfo(slowID).readState, Eq(ReadState::Current));
+  ASSERT_TRUE(testDrv->connected);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The reads for all the scalar groups are sent before waiting for any
+ *        response (one round trip per poll cycle) and all the responses are
+ *        applied
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, readsAllScalarGroupsInOneRoundTrip) {
+  string events;
+
+  recordCmdsAndEcho(
+    [&] (const vector<uint32_t> &cmd) {
+      events += 'r';  return readRegsResp(cmd, htonl(7)); },
+    [&] (Unused) { events += 'w';  return 1; });
+
+  addParams();
+
+  ASSERT_THAT(testDrv->updateScalarReadValues(), Eq(asynSuccess));
+
+  ASSERT_THAT(events, Eq("wwwrrr"));
+  ASSERT_THAT(testDrv->getParamInfo(testParamID_RO).ctlrValRead, Eq(7u));
+  ASSERT_THAT(testDrv->getParamInfo(testParamID_WA).ctlrValRead, Eq(7u));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Only the regs that changed since the last response are passed on to
+ *        their params, except after a reset
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, appliesOnlyChangedRegValues) {
+  addParams();
+  int firstID = testDrv->findParamByName("lcpRegWA_1");
+  auto readState = [&](int paramID) {
+    return testDrv->getParamInfo(paramID).readState; };
+
+  LCPReadRegs readCmd(0x20000, 5, 0);
+  auto &respBuf = readCmd.getRespBuf();
+  for (uint32_t u=0; u<5; ++u)  respBuf.at(5 + u) = htonl(10 + u);
+
+  lock_guard<drvFGPDB> asynLock(*testDrv);
+
+  ASSERT_THAT(testDrv->applyReadRegsResp(readCmd), Eq(asynSuccess));
+  ASSERT_THAT(readState(testParamID_WA), Eq(ReadState::Pending));
+  ASSERT_THAT(testDrv->getParamInfo(lastRegID_WA).ctlrValRead, Eq(14u));
+  testDrv->postNewReadings();
+
+  // unchanged values don't reach the params
+  testDrv->getParamInfo(firstID).ctlrValRead = 99;
+  respBuf.at(5 + 3) = htonl(42);
+  testDrv->applyReadRegsResp(readCmd);
+  ASSERT_THAT(testDrv->pendingReadings, ElementsAre(testParamID_WA + 1));
+  ASSERT_THAT(testDrv->getParamInfo(testParamID_WA + 1).ctlrValRead, Eq(42u));
+  ASSERT_THAT(testDrv->getParamInfo(firstID).ctlrValRead, Eq(99u));
+  testDrv->postNewReadings();
+
+  testDrv->resetReadStates();
+  testDrv->applyReadRegsResp(readCmd);
+  ASSERT_THAT(testDrv->getParamInfo(firstID).ctlrValRead, Eq(10u));
+  ASSERT_THAT(readState(lastRegID_WA), Eq(ReadState::Pending));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief With a streamInterval, the driver subscribes to the RO group values,
+ *        applies the values pushed by the ctlr and stops polling the RO group
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, streamsROGroupInsteadOfPolling) {
+  vector<vector<uint32_t>> allSent;
+
+  // (the ctlr pushes the stream values instead of responding to the cmd)
+  recordCmdsAndEcho(
+    [] (const vector<uint32_t> &cmd) { return readRegsResp(cmd); },
+    [&] (const vector<uint32_t> &cmd) {
+      allSent.push_back(cmd);
+      return (ntohl(cmd[0]) & drvFGPDB::AsyncPktIDFlag) ? 0 : 1; });
+
+  addParams();
+  testDrv->connected = true;
+  testDrv->streamInterval = 50;
+
+  testDrv->updateStream();
+
+  ASSERT_THAT(allSent.size(), Eq(1u));
+  uint32_t streamPktID = ntohl(allSent[0][0]);
+  ASSERT_TRUE(streamPktID & drvFGPDB::AsyncPktIDFlag);
+  ASSERT_THAT(ntohl(allSent[0][2]), Eq(0x10000u));
+  ASSERT_THAT(ntohl(allSent[0][4]), Eq(50u));
+
+  // the ctlr pushes new values
+  vector<uint32_t> pushed(allSent[0].size() + ntohl(allSent[0][3]), htonl(42));
+  copy_n(allSent[0].begin(), 5, pushed.begin());
+  testDrv->dispatchResp(pushed, pushed.size() * sizeof(pushed[0]));
+
+  ASSERT_TRUE(testDrv->streamActive);
+  ASSERT_THAT(testDrv->asyncPktsRcvd, Eq(1u));
+  ASSERT_THAT(testDrv->getParamInfo(testParamID_RO).ctlrValRead, Eq(42u));
+
+  // ...so only the WA and WO groups are polled
+  allSent.clear();
+  testDrv->updateScalarReadValues();
+  ASSERT_THAT(allSent.size(), Eq(2u));
+  ASSERT_THAT(ntohl(allSent[0][2]), Eq(0x20000u));
+  ASSERT_THAT(ntohl(allSent[1][2]), Eq(0x300FFu));
+
+  // values for an old subscription are not applied
+  pushed[0] = htonl(streamPktID - 1);  pushed[5] = htonl(7);
+  testDrv->dispatchResp(pushed, pushed.size() * sizeof(pushed[0]));
+  ASSERT_THAT(testDrv->asyncPktsRcvd, Eq(2u));
+  ASSERT_THAT(testDrv->getParamInfo(testParamID_RO).ctlrValRead, Eq(42u));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The receiver thread passes each response to the cmd waiting for it
+ *        and counts (and drops) duplicate responses
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, receiverThreadDropsDuplicateResps) {
+  bool duplicateSent = false;
+
+  // the ctlr sends the response for the 1st cmd twice
+  recordCmdsAndEcho(
+    [] (const vector<uint32_t> &cmd) { return echoHdr(cmd, 5); },
+    [&] (Unused) { return duplicateSent ? 1 : (duplicateSent = true, 2); });
+
+  testDrv->rcvThread = thread(&drvFGPDB::processResponses, testDrv.get());
+
+  LCPReadRegs readRO(0x10000, 0, 0), readWA(0x20000, 0, 0);
+  LCPCmdBase * const LCPCmds[] = { &readRO, &readWA };
+
+  stat = testDrv->sendCmdsGetResps(pasynUser, LCPCmds, 2);
+
+  testDrv->exitDriver = true;  testDrv->rcvThread.join();
+
+  ASSERT_THAT(stat, Eq(asynSuccess));
+  ASSERT_TRUE(readRO.respRcvd() and readWA.respRcvd());
+  ASSERT_THAT(testDrv->latePktCount, Eq(1u));
+
+  // the counts reach their driver values with the next poll cycle
+  ASSERT_THAT(testDrv->latePktsRcvd, Eq(0u));
+  testDrv->updateScalarReadValues();
+  ASSERT_THAT(testDrv->latePktsRcvd, Eq(1u));
+  ASSERT_THAT(testDrv->syncPktsRcvd, Ge(3u));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Writes from asyn clients do not wait for a slow PMEM transfer (the
+ *        asyn lock is not held while waiting for the network): a write
+ *        finishes while the transfer is blocked waiting for the ctlr
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, clientWritesDontWaitForSlowTransfers) {
+  // the 1st response is held back until the test releases it
+  mutex latchLock;
+  condition_variable latchCond;
+  bool readBlocked = false, releaseRead = false;
+
+  recordCmdsAndEcho([&] (const vector<uint32_t> &cmd) {
+    {
+      unique_lock<mutex> lock(latchLock);
+      readBlocked = true;  latchCond.notify_all();
+      latchCond.wait(lock, [&] { return releaseRead; });
+    }
+    vector<uint32_t> resp = echoHdr(cmd, 6 + 256);
+    resp[2] = sessionWord();  // keep write access
+    return resp;
+  });
+
+  addParams();
+  testDrv->initComplete = true;  testDrv->connected = true;
+  testDrv->writeAccess = true;   testDrv->maxPktsInFlight = 1;
+
+  atomic<bool> transferDone(false);
+  thread transfer([&] {
+    vector<uint8_t> buf(16384);
+    testDrv->readBlock(0, buf.size(), 0, buf);
+    transferDone = true;
+  });
+
+  {
+    unique_lock<mutex> lock(latchLock);
+    latchCond.wait(lock, [&] { return readBlocked; });
+  }
+
+  pasynUser->reason = testParamID_WA;
+  auto clientWrite = async(launch::async, [&] {
+    lock_guard<drvFGPDB> asynLock(*testDrv);  // as the asyn layer does
+    return testDrv->writeInt32(pasynUser, 7);
+  });
+
+  // the limit only keeps a regression (a deadlock) from hanging the test
+  bool writeDone = (clientWrite.wait_for(10s) == future_status::ready);
+  bool transferBlocked = !transferDone;
+
+  {
+    lock_guard<mutex> lock(latchLock);
+    releaseRead = true;
+  }
+  latchCond.notify_all();
+  transfer.join();
+
+  ASSERT_TRUE(writeDone);
+  ASSERT_TRUE(transferBlocked);
+  ASSERT_THAT(clientWrite.get(), Eq(asynSuccess));
+  ASSERT_TRUE(transferDone);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The MTU probe finds the largest PMEM block that gets through and
+ *        block transfers are then split in to the fewest sub-blocks that fit
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, probesMTUAndSplitsBlocksToFit) {
+  vector<uint32_t> blockSizesSent;
+
+  recordCmdsAndEcho(
+    [] (const vector<uint32_t> &cmd) { return echoHdr(cmd, 6 + ntohl(cmd[3]) / 4); },
+    [&] (const vector<uint32_t> &cmd) {
+      blockSizesSent.push_back(ntohl(cmd[3]));
+      // the network drops anything that doesn't fit in a 2100 byte MTU
+      return (ntohl(cmd[3]) + drvFGPDB::PmemPktOverhead <= 2100) ? 1 : 0; });
+
+  ASSERT_THAT(drvFGPDB::maxPmemPayload(1500), Eq(1024u));
+  ASSERT_THAT(drvFGPDB::maxPmemPayload(9000), Eq(8192u));
+
+  useShortRTTs();
+
+  // each size is only sent once
+  testDrv->probeMTU = 9000;
+  ASSERT_THAT(testDrv->probeEtherMTU(), Eq(asynSuccess));
+  ASSERT_THAT(testDrv->etherMTU, Eq(2048 + drvFGPDB::PmemPktOverhead));
+  ASSERT_THAT(blockSizesSent, ElementsAre(8192, 4096, 2048));
+
+  // the sizes that failed are not tried again (e.g. after a reconnect)
+  blockSizesSent.clear();
+  testDrv->etherMTU = 1500;
+  ASSERT_THAT(testDrv->probeEtherMTU(), Eq(asynSuccess));
+  ASSERT_THAT(blockSizesSent, ElementsAre(2048));
+
+  blockSizesSent.clear();
+  vector<uint8_t> buf(8192);
+  ASSERT_THAT(testDrv->readBlock(0, buf.size(), 1, buf), Eq(asynSuccess));
+  ASSERT_THAT(blockSizesSent, ElementsAre(2048, 2048, 2048, 2048));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief A PMEM array is read with bursts of sub-block reads that are all in
+ *        flight at the same time, the data goes straight to its place in the
+ *        array value, and only the sub-blocks that got no response are read
+ *        again
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, streamsPMEMReadsAndRereadsOnlyMissingSubBlocks) {
+  vector<uint32_t> blockNumsSent;
+  int numDropped = 0;
+
+  recordCmdsAndEcho(
+    [&] (const vector<uint32_t> &cmd) {
+      uint32_t blockSize = ntohl(cmd[3]), blockNum = ntohl(cmd[4]);
+      vector<uint32_t> resp = echoHdr(cmd, 6 + blockSize / 4);
+      auto data = reinterpret_cast<uint8_t *>(resp.data() + 6);
+      for (uint32_t u=0; u<blockSize; ++u)  data[u] = chipByte(blockNum * blockSize + u);
+      return resp;
+    },
+    [&] (const vector<uint32_t> &cmd) {
+      blockNumsSent.push_back(ntohl(cmd[4]));
+      // every attempt to read sub-block 5 in the 1st burst is lost
+      if ((ntohl(cmd[4]) == 5) and (numDropped < drvFGPDB::MaxMsgAttempts))  {
+        ++numDropped;  return 0; }
+      return 1;
+    });
+
+  addParams();
+  int rateParamID = addParam("pmemStreamReadRate 0x1 Int32");
+  int paramID = addParam("pmemStreamTest 0x2 1 1024 N 0x100 0x3000 "
+                         "pmemReadStatus pmemWriteStatus pmemStreamReadRate");
+  ASSERT_THAT(paramID, Ge(0));
+  testDrv->completeArrayParamInit();
+  ParamInfo &param = testDrv->params.at(paramID);
+  ASSERT_THAT(param.rdRateParamID, Eq(rateParamID));
+  ASSERT_THAT(testDrv->params.at(testArrayID).rdRateParamID, Eq(-1));
+  testDrv->connected = true;
+  useShortRTTs();
+
+  // 1st burst: the 13 sub-blocks of 1024 bytes that hold bytes 0x100-0x30FF
+  ASSERT_THAT(testDrv->readNextBlock(param), Eq(asynSuccess));
+  ASSERT_THAT(param.subBlockSize, Eq(1024u));
+  ASSERT_THAT(param.unreadSubBlocks, ElementsAre(5));
+  ASSERT_THAT(param.getBytesLeft(), Eq(1024u));
+  ASSERT_THAT(blockNumsSent.front(), Eq(0u));
+  ASSERT_THAT(blockNumsSent.size(), Eq(size_t(12 + drvFGPDB::MaxMsgAttempts)));
+  ASSERT_THAT(count(blockNumsSent.begin(), blockNumsSent.end(), 5u),
+              Eq(drvFGPDB::MaxMsgAttempts));
+
+  // 2nd burst: only the one that got no response
+  blockNumsSent.clear();
+  ASSERT_THAT(testDrv->readNextBlock(param), Eq(asynSuccess));
+  ASSERT_THAT(blockNumsSent, ElementsAre(5));
+  ASSERT_THAT(param.getBytesLeft(), Eq(0u));
+  ASSERT_THAT(param.readRate, Gt(0u));
+  ASSERT_THAT(testDrv->params.at(rateParamID).ctlrValRead, Eq(param.readRate));
+
+  for (uint32_t u=0; u<param.arrayValRead.size(); ++u)
+    ASSERT_THAT(param.arrayValRead[u], Eq(chipByte(0x100 + u))) << "at " << u;
+
+  ASSERT_THAT(testDrv->readNextBlock(param), Eq(asynSuccess));
+  ASSERT_THAT(param.readState, Eq(ReadState::Pending));
+  ASSERT_THAT(testDrv->activeArrayReads, Not(Contains(paramID)));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Pending settings are merged in to one WRITE_REGS cmd for each run of
+ *        contiguous regs, and settings the ctlr rejects are flagged as errors
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, mergesContiguousSettingsInToOneWriteCmd) {
+  vector<pair<uint32_t, uint32_t>> rangesSent;
+  uint32_t rejectAddr = 0;
+
+  recordCmdsAndEcho(
+    [&] (const vector<uint32_t> &cmd) {
+      vector<uint32_t> resp = echoHdr(cmd, 5);
+      resp[2] = sessionWord((ntohl(cmd[2]) == rejectAddr) ?
+                            static_cast<uint16_t>(LCPStatus::INVALID_PARAM) : 0);
+      return resp;
+    },
+    [&] (const vector<uint32_t> &cmd) {
+      rangesSent.emplace_back(ntohl(cmd[2]), ntohl(cmd[3]));  return 1; });
+
+  addParams();
+  testDrv->initComplete = true;  testDrv->connected = true;
+  testDrv->writeAccess = true;
+  useShortRTTs();
+
+  vector<string> names = { "lcpRegWA_1", "lcpRegWA_2", "lcpRegWA_3",
+                           "lcpRegWA_4", "lcpRegWO_2" };
+  for (auto &name : names)  {
+    ParamInfo &param = testDrv->params.at(testDrv->findParamByName(name));
+    param.ctlrValSet = 7;  testDrv->updateSetting(param, SetState::Pending);
+  }
+
+  ASSERT_THAT(testDrv->writePendingRegs(), Eq(asynSuccess));
+  ASSERT_THAT(rangesSent, ElementsAre(Pair(0x20000u, 1u), Pair(0x20002u, 3u),
+                                      Pair(0x300FFu, 1u)));
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+  for (auto &name : names)
+    ASSERT_THAT(testDrv->params.at(testDrv->findParamByName(name)).setState,
+                Eq(SetState::Sent));
+
+  // nothing left to send
+  rangesSent.clear();
+  ASSERT_THAT(testDrv->writePendingRegs(), Eq(asynSuccess));
+  ASSERT_THAT(rangesSent, IsEmpty());
+
+  rejectAddr = 0x20002;
+  for (auto &name : names)
+    testDrv->updateSetting(testDrv->params.at(testDrv->findParamByName(name)),
+                           SetState::Pending);
+  ASSERT_THAT(testDrv->writePendingRegs(), Eq(asynSuccess));
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+  ASSERT_THAT(testDrv->params.at(testParamID_WA).setState, Eq(SetState::Error));
+  ASSERT_THAT(testDrv->params.at(testDrv->findParamByName("lcpRegWA_1")).setState,
+              Eq(SetState::Sent));
+  asynStatus paramStat;
+  testDrv->getParamStatus(testParamID_WA, &paramStat);
+  ASSERT_THAT(paramStat, Eq(asynError));
+
+  // the error is cleared once a new setting is accepted
+  rejectAddr = 0;
+  testDrv->updateSetting(testDrv->params.at(testParamID_WA), SetState::Pending);
+  ASSERT_THAT(testDrv->writePendingRegs(), Eq(asynSuccess));
+  ASSERT_THAT(testDrv->params.at(testParamID_WA).setState, Eq(SetState::Sent));
+  testDrv->getParamStatus(testParamID_WA, &paramStat);
+  ASSERT_THAT(paramStat, Eq(asynSuccess));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief New readings are sorted by asyn type and each type is passed to the
+ *        asyn param library in its own pass
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, postsNewReadingsInBatchesByAsynType) {
+  addParams();
+  int floatID = addParam("lcpRegRO_3 0x10003 Float64 F32");
+  ASSERT_THAT(floatID, Ge(0));
+  ASSERT_THAT(testDrv->idPostWindow, Ge(0));
+  ASSERT_THAT(testDrv->postWindow, Eq(5u));
+
+  float fval = 2.5;
+  uint32_t rawFloat;
+  memcpy(&rawFloat, &fval, sizeof(rawFloat));
+
+  testDrv->postNewReadings();
+  {
+    lock_guard<drvFGPDB> asynLock(*testDrv);
+    testDrv->params.at(testParamID_WA).newReadVal(42);
+    testDrv->params.at(floatID).newReadVal(rawFloat);
+    testDrv->params.at(testDrv->idStateFlags).newReadVal(0x5);
+  }
+  testDrv->postNewReadings();
+
+  ASSERT_THAT(testDrv->postBatches.int32IDs, ElementsAre(testParamID_WA));
+  ASSERT_THAT(testDrv->postBatches.float64IDs, ElementsAre(floatID));
+  ASSERT_THAT(testDrv->postBatches.float64Vals, ElementsAre(DoubleEq(2.5)));
+  ASSERT_THAT(testDrv->postBatches.digitalIDs, ElementsAre(testDrv->idStateFlags));
+  ASSERT_THAT(testDrv->pendingReadings, IsEmpty());
+
+  int ival;  double dval;  epicsUInt32 uval;
+  testDrv->getIntegerParam(0, testParamID_WA, &ival);
+  testDrv->getDoubleParam(0, floatID, &dval);
+  testDrv->getUIntDigitalParam(0, testDrv->idStateFlags, &uval, 0xFFFFFFFF);
+  ASSERT_THAT(ival, Eq(42));
+  ASSERT_THAT(dval, DoubleEq(2.5));
+  ASSERT_THAT(uval, Eq(0x5u));
+  for (int paramID : { testParamID_WA, floatID, testDrv->idStateFlags })
+    ASSERT_THAT(testDrv->getParamInfo(paramID).readState, Eq(ReadState::Current));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The shadow of the settings in each ProcGroup follows the params
+ *        through every path that changes a setting, and the write path takes
+ *        the values to send from it
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, keepsSettingsShadowInSyncWithParams) {
+  addParams();
+  ProcGroup &group = testDrv->getProcGroup(ProcGroup_LCP_WA);
+  unsigned int offset = LCPUtil::addrOffset(testDrv->params.at(testParamID_WA).getRegAddr());
+
+  ASSERT_THAT(group.setStates.size(), Eq(group.paramIDs.size()));
+  ASSERT_THAT(group.setVals.size(), Eq(group.paramIDs.size()));
+  ASSERT_THAT(group.findSetState(0, SetState::Pending), Eq(group.setStates.size()));
+  ASSERT_FALSE(testDrv->pendingRegSettings());
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+
+  pasynUser->reason = testParamID_WA;
+  {
+    lock_guard<drvFGPDB> asynLock(*testDrv);  // as the asyn layer does
+    ASSERT_THAT(testDrv->writeInt32(pasynUser, 42), Eq(asynSuccess));
+  }
+  ASSERT_THAT(group.setVals[offset], Eq(42u));
+  ASSERT_THAT(group.setStates[offset], Eq(static_cast<uint8_t>(SetState::Restored)));
+
+  testDrv->clearSetStates();
+  ASSERT_THAT(testDrv->params.at(testParamID_WA).setState, Eq(SetState::Sent));
+  ASSERT_THAT(group.setStates[offset], Eq(static_cast<uint8_t>(SetState::Sent)));
+  ASSERT_FALSE(testDrv->pendingRegSettings());
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+
+  testDrv->resetSetStates();
+  ASSERT_THAT(testDrv->params.at(testParamID_WA).setState, Eq(SetState::Pending));
+  ASSERT_THAT(group.findSetState(0, SetState::Pending), Eq(offset));
+  ASSERT_TRUE(testDrv->pendingRegSettings());
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+
+  LCPWriteRegs writeCmd(testDrv->params.at(testParamID_WA).getRegAddr(), 1);
+  {
+    lock_guard<drvFGPDB> asynLock(*testDrv);
+    ASSERT_THAT(testDrv->loadWriteRegsCmd(writeCmd), Eq(asynSuccess));
+  }
+  ASSERT_THAT(writeCmd.getCmdBufData(writeCmd.getCmdHdrWords()), Eq(42u));
+  ASSERT_THAT(testDrv->params.at(testParamID_WA).setState, Eq(SetState::Processing));
+  ASSERT_THAT(group.setStates[offset], Eq(static_cast<uint8_t>(SetState::Processing)));
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+
+  {
+    lock_guard<drvFGPDB> asynLock(*testDrv);
+    testDrv->finishWriteRegsCmd(writeCmd, SetState::Sent);
+  }
+  ASSERT_THAT(testDrv->params.at(testParamID_WA).setState, Eq(SetState::Sent));
+  ASSERT_THAT(group.setStates[offset], Eq(static_cast<uint8_t>(SetState::Sent)));
+  ASSERT_FALSE(testDrv->pendingRegSettings());
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+
+  pasynUser->reason = lastRegID_WA;
+  {
+    lock_guard<drvFGPDB> asynLock(*testDrv);
+    ASSERT_THAT(testDrv->writeFloat64(pasynUser, 1.5), Eq(asynSuccess));
+  }
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+
+  // array params have no shadow, and changing their state leaves it alone
+  testDrv->connected = true;
+  ASSERT_THAT(clientWriteInt8Array(testArrayID, vector<epicsInt8>(256, 1)),
+              Eq(asynSuccess));
+  testDrv->cancelArrayWrites();
+  ASSERT_THAT(testDrv->params.at(testArrayID).setState, Eq(SetState::Error));
+  ASSERT_THAT(settingsOutOfSync(), Eq(0u));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The array timers only visit the array params with an active read or
+ *        write, and go to sleep when there are none
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, tracksActiveArrayTransfers) {
+  addParams();
+  ParamInfo &param = testDrv->params.at(testArrayID);
+
+  // a new PMEM param is read once the ctlr is online
+  ASSERT_THAT(testDrv->activeArrayReads, ElementsAre(testArrayID));
+  ASSERT_THAT(testDrv->activeArrayWrites, IsEmpty());
+  ASSERT_THAT(testDrv->processArrayReads(), Eq(1.0));  // not connected yet
+
+  vector<epicsInt8> newVal(16, 1);
+  ASSERT_THAT(clientWriteInt8Array(testArrayID, newVal), Eq(asynSuccess));
+  ASSERT_THAT(testDrv->activeArrayWrites, ElementsAre(testArrayID));
+
+  testDrv->cancelArrayWrites();
+  ASSERT_THAT(testDrv->activeArrayWrites, IsEmpty());
+  ASSERT_THAT(param.setState, Eq(SetState::Error));
+  ASSERT_THAT(testDrv->processArrayWrites(), Eq(DontReschedule));
+
+  // the read is done once there are no bytes left to read
+  testDrv->connected = true;
+  param.reduceBytesLeftBy(param.getBytesLeft());
+  ASSERT_THAT(testDrv->readNextBlock(param), Eq(asynSuccess));
+  ASSERT_THAT(testDrv->activeArrayReads, IsEmpty());
+  ASSERT_THAT(param.readState, Eq(ReadState::Pending));
+  ASSERT_THAT(testDrv->processArrayReads(), Eq(DontReschedule));
+
+  testDrv->initArrayReadback(param);
+  ASSERT_THAT(testDrv->activeArrayReads, ElementsAre(testArrayID));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief A new PMEM array value only erases and writes the blocks that differ
+ *        from the last value read from the ctlr, and the write progress is
+ *        relative to those blocks
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, writesOnlyChangedPMEMBlocks) {
+  vector<pair<uint32_t, uint32_t>> blockCmdsSent;  // (LCP cmd, block #)
+
+  recordCmdsAndEcho(
+    [&] (const vector<uint32_t> &cmd) {
+      vector<uint32_t> resp = echoHdr(cmd, 6);
+      resp[2] = sessionWord();  // keep write access
+      return resp;
+    },
+    [&] (const vector<uint32_t> &cmd) {
+      blockCmdsSent.emplace_back(ntohl(cmd[1]), ntohl(cmd[4]));  return 1; });
+
+  addParams();
+  int paramID = addParam("pmemDeltaTest 0x2 1 256 Y 0x1000 0x1000 "
+                         "pmemReadStatus pmemWriteStatus");
+  ASSERT_THAT(paramID, Ge(0));
+  testDrv->completeArrayParamInit();
+  ParamInfo &param = testDrv->params.at(paramID);
+  param.readState = ReadState::Current;  // last value read was all 0s
+  testDrv->activeArrayReads.erase(paramID);
+  useShortRTTs();
+
+  vector<epicsInt8> newVal(0x1000, 0);
+  newVal.at(0x305) = 1;  newVal.at(0x3FF) = 2;  // both in block 0x13
+  ASSERT_THAT(clientWriteInt8Array(paramID, newVal), Eq(asynSuccess));
+  ASSERT_THAT(param.getWorkSize(), Eq(256u));
+
+  testDrv->connected = true;  testDrv->writeAccess = true;
+  for (int u=0; u<20 and param.activePMEMwrite(); ++u)
+    ASSERT_THAT(testDrv->writeNextBlock(param), Eq(asynSuccess));
+
+  const uint32_t erase = static_cast<uint32_t>(LCPCommand::ERASE_BLOCK),
+                 write = static_cast<uint32_t>(LCPCommand::WRITE_BLOCK),
+                 checksum = static_cast<uint32_t>(LCPCommand::CHECKSUM_BLOCK);
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(erase, 0x13u), Pair(write, 0x13u),
+                                         Pair(checksum, 0x13u)));
+  ASSERT_THAT(param.setState, Eq(SetState::Sent));
+  // the mock ctlr's CRC (0) doesn't match, so the array is read back
+  ASSERT_THAT(testDrv->activeArrayReads, Contains(paramID));
+  ASSERT_THAT(testDrv->params.at(arrayWriteStatusID).ctlrValRead, Eq(100u));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The read-modify-write of a partial block takes the existing bytes
+ *        from the block cache filled by the last read, and only reads them
+ *        from the ctlr when the cached copy is stale
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, mergesPartialBlockWritesWithCachedBlocks) {
+  vector<pair<uint32_t, uint32_t>> blockCmdsSent;  // (LCP cmd, block #)
+  map<uint32_t, vector<uint8_t>> blocksWritten;
+
+  const uint32_t readCmd = static_cast<uint32_t>(LCPCommand::READ_BLOCK),
+                 writeCmd = static_cast<uint32_t>(LCPCommand::WRITE_BLOCK),
+                 checksumCmd = static_cast<uint32_t>(LCPCommand::CHECKSUM_BLOCK);
+
+  recordCmdsAndEcho(
+    [&] (const vector<uint32_t> &cmd) {
+      uint32_t blockSize = ntohl(cmd[3]), blockNum = ntohl(cmd[4]);
+      vector<uint32_t> resp =
+        echoHdr(cmd, 6 + ((ntohl(cmd[1]) == readCmd) ? blockSize / 4 : 0));
+      resp[2] = sessionWord();  // keep write access
+      auto data = reinterpret_cast<uint8_t *>(resp.data() + 6);
+      for (uint32_t u=0; 6 + u/4 < resp.size(); ++u)
+        data[u] = chipByte(blockNum * blockSize + u);
+      return resp;
+    },
+    [&] (const vector<uint32_t> &cmd) {
+      blockCmdsSent.emplace_back(ntohl(cmd[1]), ntohl(cmd[4]));
+      if (ntohl(cmd[1]) == writeCmd)  {
+        auto data = reinterpret_cast<const uint8_t *>(cmd.data() + 5);
+        blocksWritten[ntohl(cmd[4])].assign(data, data + (cmd.size() - 5) * 4);
+      }
+      return 1;
+    });
+
+  addParams();
+  // blocks 0x10 (2nd half), 0x11 and 0x12 (1st half)
+  int paramID = addParam("pmemCacheTest 0x2 1 256 N 0x1080 0x200 "
+                         "pmemReadStatus pmemWriteStatus");
+  ASSERT_THAT(paramID, Ge(0));
+  ParamInfo &param = testDrv->params.at(paramID);
+  testDrv->connected = true;  testDrv->writeAccess = true;
+  useShortRTTs();
+
+  while (testDrv->activeArrayReads.count(paramID))
+    ASSERT_THAT(testDrv->readNextBlock(param), Eq(asynSuccess));
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(readCmd, 0x10u), Pair(readCmd, 0x11u),
+                                         Pair(readCmd, 0x12u)));
+  ASSERT_THAT(param.blockValid, ElementsAre(true, true, true));
+  param.readState = ReadState::Current;  // as if posted
+
+  auto writeArray = [&] (vector<epicsInt8> newVal) {
+    ASSERT_THAT(clientWriteInt8Array(paramID, newVal), Eq(asynSuccess));
+    for (int u=0; u<20 and param.activePMEMwrite(); ++u)
+      ASSERT_THAT(testDrv->writeNextBlock(param), Eq(asynSuccess));
+  };
+
+  // change a byte in each of the partial blocks: no reads needed
+  vector<epicsInt8> newVal(param.arrayValRead.begin(), param.arrayValRead.end());
+  newVal.front() = 1;  newVal.back() = 2;
+  blockCmdsSent.clear();
+  writeArray(newVal);
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(writeCmd, 0x10u), Pair(writeCmd, 0x12u),
+                                         Pair(checksumCmd, 0x10u),
+                                         Pair(checksumCmd, 0x12u)));
+  for (uint32_t u=0; u<0x80; ++u)  {
+    ASSERT_THAT(blocksWritten[0x10].at(u), Eq(chipByte(0x1000 + u))) << "at " << u;
+    ASSERT_THAT(blocksWritten[0x12].at(0x80 + u), Eq(chipByte(0x1280 + u))) << "at " << u;
+  }
+  ASSERT_THAT(blocksWritten[0x10].at(0x80), Eq(1));
+  ASSERT_THAT(blocksWritten[0x12].at(0x7F), Eq(2));
+  ASSERT_THAT(param.blockValid, ElementsAre(false, true, false));
+
+  // before the readback the written blocks have to be read from the ctlr
+  blockCmdsSent.clear();
+  writeArray(newVal);
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(readCmd, 0x10u), Pair(writeCmd, 0x10u),
+                                         Pair(writeCmd, 0x11u),
+                                         Pair(readCmd, 0x12u), Pair(writeCmd, 0x12u),
+                                         Pair(checksumCmd, 0x10u),
+                                         Pair(checksumCmd, 0x11u),
+                                         Pair(checksumCmd, 0x12u)));
+
+  // the cached blocks are not trusted after the ctlr restarts or goes
+  // offline, until they are read again
+  testDrv->resetReadStates();
+  ASSERT_THAT(param.blockValid, Each(false));
+  blockCmdsSent.clear();
+  while (testDrv->activeArrayReads.count(paramID))
+    ASSERT_THAT(testDrv->readNextBlock(param), Eq(asynSuccess));
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(readCmd, 0x10u), Pair(readCmd, 0x11u),
+                                         Pair(readCmd, 0x12u)));
+  ASSERT_THAT(param.blockValid, ElementsAre(true, true, true));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief After a write the ctlr's CRC-32C of each block written is compared
+ *        with the CRC of the bytes sent.  Nothing is read back if they
+ *        match, all of the array is read back if they don't (or if
+ *        pmemFullReadback is set), and only the blocks written are read back
+ *        if the ctlr doesn't have the CHECKSUM_BLOCK cmd.
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, verifiesWritesWithBlockChecksums) {
+  vector<pair<uint32_t, uint32_t>> blockCmdsSent;  // (LCP cmd, block #)
+  vector<uint8_t> chip(0x2000, 0);
+  bool corruptWrites = false, checksumSupported = true;
+
+  const uint32_t readCmd = static_cast<uint32_t>(LCPCommand::READ_BLOCK),
+                 writeCmd = static_cast<uint32_t>(LCPCommand::WRITE_BLOCK),
+                 checksumCmd = static_cast<uint32_t>(LCPCommand::CHECKSUM_BLOCK);
+
+  recordCmdsAndEcho(
+    [&] (const vector<uint32_t> &cmd) {
+      uint32_t blockSize = ntohl(cmd[3]), blockNum = ntohl(cmd[4]);
+      bool isRead = (ntohl(cmd[1]) == readCmd),
+           isChecksum = (ntohl(cmd[1]) == checksumCmd);
+      vector<uint32_t> resp = echoHdr(cmd, 6 + (isRead ? blockSize / 4 : 0) +
+                                           (isChecksum ? 1 : 0));
+      resp[2] = sessionWord();  // keep write access
+      if (isRead)
+        memcpy(resp.data() + 6, chip.data() + blockNum * blockSize, blockSize);
+      if (isChecksum and checksumSupported)
+        resp[6] = htonl(LCPUtil::crc32c(chip.data() + blockNum * blockSize,
+                                        blockSize));
+      if (isChecksum and !checksumSupported)
+        resp[2] = sessionWord(static_cast<uint16_t>(LCPStatus::INVALID_CMD));
+      return resp;
+    },
+    [&] (const vector<uint32_t> &cmd) {
+      uint32_t blockSize = ntohl(cmd[3]), blockNum = ntohl(cmd[4]);
+      blockCmdsSent.emplace_back(ntohl(cmd[1]), blockNum);
+      if (ntohl(cmd[1]) == writeCmd)  {
+        memcpy(chip.data() + blockNum * blockSize, cmd.data() + 5, blockSize);
+        if (corruptWrites)  chip.at(blockNum * blockSize) ^= 0xFF;
+      }
+      return 1;
+    });
+
+  addParams();
+  // blocks 0x10 to 0x1F
+  int paramID = addParam("pmemVerifyTest 0x2 1 256 N 0x1000 0x1000 "
+                         "pmemReadStatus pmemWriteStatus");
+  ASSERT_THAT(paramID, Ge(0));
+  ParamInfo &param = testDrv->params.at(paramID);
+  testDrv->connected = true;  testDrv->writeAccess = true;
+  useShortRTTs();
+
+  auto readBack = [&] () {
+    blockCmdsSent.clear();
+    for (int u=0; u<20 and testDrv->activeArrayReads.count(paramID); ++u)
+      ASSERT_THAT(testDrv->readNextBlock(param), Eq(asynSuccess));
+    param.readState = ReadState::Current;  // as if posted
+  };
+  auto writeArray = [&] (vector<epicsInt8> newVal) {
+    blockCmdsSent.clear();
+    ASSERT_THAT(clientWriteInt8Array(paramID, newVal), Eq(asynSuccess));
+    for (int u=0; u<20 and param.activePMEMwrite(); ++u)
+      ASSERT_THAT(testDrv->writeNextBlock(param), Eq(asynSuccess));
+    ASSERT_THAT(param.setState, Eq(SetState::Sent));
+  };
+
+  readBack();
+  ASSERT_THAT(blockCmdsSent.size(), Eq(16u));
+
+  // a good write: the CRC of its block matches, nothing is read back
+  vector<epicsInt8> newVal(0x1000, 0);
+  newVal.at(0x305) = 1;  newVal.at(0x3FF) = 2;  // both in block 0x13
+  writeArray(newVal);
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(writeCmd, 0x13u),
+                                         Pair(checksumCmd, 0x13u)));
+  ASSERT_FALSE(testDrv->activeArrayReads.count(paramID));
+  ASSERT_THAT(param.readState, Eq(ReadState::Pending));
+  ASSERT_THAT(param.arrayValRead, ElementsAreArray(newVal.begin(), newVal.end()));
+  readBack();
+  ASSERT_THAT(blockCmdsSent, IsEmpty());
+
+  // a bad write: the mismatch forces a full readback
+  newVal.at(0x410) = 3;  // block 0x14
+  corruptWrites = true;
+  writeArray(newVal);
+  corruptWrites = false;
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(writeCmd, 0x14u),
+                                         Pair(checksumCmd, 0x14u)));
+  readBack();
+  ASSERT_THAT(blockCmdsSent.size(), Eq(16u));
+  ASSERT_THAT(param.arrayValRead,
+              ElementsAreArray(chip.begin() + 0x1000, chip.begin() + 0x2000));
+
+  // a ctlr without the cmd: only the block written is read back (and the
+  // read rate is only for the bytes read)
+  checksumSupported = false;
+  newVal.assign(chip.begin() + 0x1000, chip.begin() + 0x2000);
+  newVal.at(0x520) = 5;  // block 0x15
+  writeArray(newVal);
+  ASSERT_TRUE(param.verifyingWrite());
+  readBack();
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(readCmd, 0x15u)));
+  ASSERT_THAT(param.streamBytes, Eq(0x100u));
+  ASSERT_THAT(param.arrayValRead, ElementsAreArray(newVal.begin(), newVal.end()));
+  checksumSupported = true;
+
+  // a full readback when requested
+  testDrv->pmemFullReadback = 1;
+  newVal.at(0x10) = 4;  // block 0x10
+  writeArray(newVal);
+  ASSERT_THAT(blockCmdsSent, ElementsAre(Pair(writeCmd, 0x10u)));
+  ASSERT_FALSE(param.verifyingWrite());
+  readBack();
+  ASSERT_THAT(blockCmdsSent.size(), Eq(16u));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief A waveform is read with READ_WAVEFORM cmds that each fit in a
+ *        datagram, and the values are decoded in to the preallocated buffers
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, readsWaveformInChunksThatFitInMTU) {
+  vector<uint32_t> countsSent;
+  uint32_t valsMissing = 0;  // # of values left out of the last chunk
+
+  recordCmdsAndEcho(
+    [&] (const vector<uint32_t> &cmd) {
+      uint32_t offset = ntohl(cmd[3]), count = ntohl(cmd[4]);
+      if (offset + count == 1000)  count -= valsMissing;
+      vector<uint32_t> resp = echoHdr(cmd, 9 + count);
+      for (uint32_t u=0; u<count; ++u)  {
+        float fval = offset + u;  uint32_t ival;
+        memcpy(&ival, &fval, sizeof(ival));  resp.at(9 + u) = htonl(ival);
+      }
+      return resp;
+    },
+    [&] (const vector<uint32_t> &cmd) {
+      EXPECT_THAT(ntohl(cmd[1]), Eq(static_cast<uint32_t>(LCPCommand::READ_WAVEFORM)));
+      EXPECT_THAT(ntohl(cmd[2]), Eq(3u));
+      countsSent.push_back(ntohl(cmd[4]));
+      return 1;
+    });
+
+  int paramID = testDrv->processParamDef("cavAmpWF 0x1 WF 3 1000 Float64Array F32");
+  ASSERT_THAT(paramID, Ge(0));
+  ParamInfo &param = testDrv->params.at(paramID);
+
+  ASSERT_THAT(drvFGPDB::maxWaveformCount(1500), Eq(359u));
+
+  useShortRTTs();
+
+  testDrv->etherMTU = 1500;
+  ASSERT_THAT(testDrv->readWaveform(param), Eq(asynSuccess));
+  ASSERT_THAT(countsSent, ElementsAre(359, 359, 282));
+  ASSERT_THAT(param.readState, Eq(ReadState::Pending));
+
+  param.convertWaveform();
+  ASSERT_THAT(param.wfFloat64.at(0), DoubleEq(0.0));
+  ASSERT_THAT(param.wfFloat64.at(500), DoubleEq(500.0));
+  ASSERT_THAT(param.wfFloat64.at(999), DoubleEq(999.0));
+
+  // the cmds (and their buffers) are reused for the next read
+  const LCPReadWF *firstCmd = testDrv->wfReadCmds.data();
+  ASSERT_THAT(testDrv->readWaveform(param), Eq(asynSuccess));
+  ASSERT_THAT(testDrv->wfReadCmds.data(), Eq(firstCmd));
+
+  // a short response fails the read (instead of leaving the old values in
+  // the tail of the chunk)
+  valsMissing = 1;
+  param.readState = ReadState::Current;
+  ASSERT_THAT(testDrv->readWaveform(param), Eq(asynError));
+  ASSERT_THAT(param.readState, Eq(ReadState::Current));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The driver-only values are all posted the 1st time, then only the
+ *        ones flagged as changed are refreshed
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, refreshesOnlyChangedDriverValues) {
+  addParams();
+  testDrv->buildDrvValueIndex();
+
+  auto refresh = [&]() {  // without the poll cmds (they change the counters)
+    testDrv->exitDriver = true;
+    testDrv->updateScalarReadValues();
+    testDrv->exitDriver = false;
+  };
+
+  refresh();
+  ASSERT_THAT(testDrv->pendingReadings, Contains(testDrv->idSyncPktsSent));
+  ASSERT_THAT(testDrv->pendingReadings, Contains(testDrv->idWriteWindow));
+  testDrv->postNewReadings();
+
+  refresh();
+  ASSERT_THAT(testDrv->pendingReadings, IsEmpty());
+
+  {
+    lock_guard<drvFGPDB> asynLock(*testDrv);
+    testDrv->syncPktsSent = 5;
+    testDrv->drvValueChgd(testDrv->idSyncPktsSent);
+  }
+  refresh();
+  ASSERT_THAT(testDrv->pendingReadings, ElementsAre(testDrv->idSyncPktsSent));
+  ASSERT_THAT(testDrv->getParamInfo(testDrv->idSyncPktsSent).ctlrValRead,
+              Eq(5u));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Benchmark of posting new readings with 10k params and 50 (0.5%)
+ *        new readings per cycle (the results are printed, only the posted
+ *        values are checked).  Run with --gtest_also_run_disabled_tests.
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, DISABLED_benchmarkPostingFewChangesOf10kParams) {
+  const int numParams = 10000, numChgs = 50, numCycles = 200;
+
+  for (int u=0; u<numParams; ++u)  {
+    ostringstream def;
+    def << "bench_" << u << " 0x" << hex << (0x10000 + u) << " Int32 U32";
+    ASSERT_THAT(testDrv->processParamDef(def.str()), Ge(0));
+  }
+  int firstID = testDrv->findParamByName("bench_0");
+
+  testDrv->postNewReadings();  // nothing pending yet
+  ASSERT_THAT(testDrv->pendingReadings, IsEmpty());
+
+  chrono::duration<double> postTime(0);
+
+  for (int cycle=0; cycle<numCycles; ++cycle)  {
+    {
+      lock_guard<drvFGPDB> asynLock(*testDrv);
+      for (int u=0; u<numChgs; ++u)  {
+        ParamInfo &param = testDrv->params.at(firstID + (cycle * 37 + u * 197) % numParams);
+        param.newReadVal(cycle);  param.newReadVal(cycle + 1);  // listed once
+      }
+    }
+    ASSERT_THAT(testDrv->pendingReadings.size(), Eq(size_t(numChgs)));
+
+    auto start = chrono::steady_clock::now();
+    testDrv->postNewReadings();
+    postTime += chrono::steady_clock::now() - start;
+
+    ASSERT_THAT(testDrv->pendingReadings, IsEmpty());
+  }
+
+  for (int u=0; u<numChgs; ++u)
+    ASSERT_THAT(testDrv->params.at(firstID + u * 197).readState,
+                Eq(ReadState::Current));
+
+  cout << "posting: " << postTime.count() / numCycles * 1e6
+       << " usecs/cycle (" << numChgs << " values/cycle)" << endl;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The retransmit timeout follows the measured RTT, doubles for each
+ *        retry and stays within the min/max limits
+ */
+TEST(AnRTTEstimator, derivesRetransmitTimeoutFromRTT) {
+  RTTEstimator est;
+
+  ASSERT_THAT(est.getRTO(1), DoubleEq(RTTEstimator::InitialRTO));
+
+  for (int u=0; u<20; ++u)  est.addSample(0.05);
+
+  ASSERT_THAT(est.getSRTT(), DoubleNear(0.05, 1e-6));
+  ASSERT_THAT(est.getRTO(1), DoubleNear(0.05, 1e-3));
+  ASSERT_THAT(est.getRTO(2), DoubleEq(2 * est.getRTO(1)));
+  ASSERT_THAT(est.getRTO(10), DoubleEq(RTTEstimator::MaxRTO));
+
+  for (int u=0; u<50; ++u)  est.addSample(0.0001);
+
+  ASSERT_THAT(est.getRTO(1), DoubleEq(RTTEstimator::MinRTO));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief ERASE_BLOCK cmds don't use the (much shorter) RTT of the other PMEM
+ *        block cmds, and all their attempts take at least as long as the
+ *        fixed timeouts did (about 1 sec)
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, keepsRetryBudgetForEraseBlockCmds) {
+  for (int u=0; u<20; ++u)  testDrv->blockRTTEst.addSample(0.001);
+
+  LCPEraseBlock eraseCmd(1, 256, 0x41);
+  LCPReadBlock readCmd(1, 256, 0x41);
+
+  RTTEstimator &eraseEst = testDrv->rttEstimator(eraseCmd);
+  ASSERT_THAT(&eraseEst, Ne(&testDrv->rttEstimator(readCmd)));
+
+  for (int u=0; u<20; ++u)  eraseEst.addSample(0.001);
+
+  double budget = 0.0;
+  for (int attempt=1; attempt<=drvFGPDB::MaxMsgAttempts; ++attempt)
+    budget += eraseEst.getRTO(attempt);
+
+  ASSERT_THAT(budget, Ge(1.0));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief The socket transport sends and receives several datagrams with one
+ *        call (checked against a local UDP socket that echoes them back), and
+ *        a shared asynUser receives the responses to what the other one sent
+ */
+TEST(AUdpSocketSyncIO, transfersSeveralDatagramsPerCall) {
+  int peer = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_THAT(peer, Ge(0));
+  sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrLen = sizeof(addr);
+  ASSERT_THAT(bind(peer, (sockaddr *)&addr, addrLen), Eq(0));
+  ASSERT_THAT(getsockname(peer, (sockaddr *)&addr, &addrLen), Eq(0));
+
+  udpSocketSyncIO syncIO;
+  asynUser *pasynUser = nullptr;
+  string hostInfo = "127.0.0.1:" + to_string(ntohs(addr.sin_port));
+  ASSERT_THAT(syncIO.connect(hostInfo.c_str(), 0, &pasynUser, nullptr),
+              Eq(asynSuccess));
+  asynUser *pasynUserRcv = nullptr;
+  ASSERT_THAT(syncIO.connectShared(hostInfo.c_str(), 0, pasynUser,
+                                   &pasynUserRcv, nullptr), Eq(asynSuccess));
+  ASSERT_THAT(syncIO.peerAddr(pasynUserRcv), Eq(hostInfo));
+
+  char msgs[3][4] = { "abc", "def", "ghi" };
+  writeData outData[3];
+  for (int u=0; u<3; ++u)  outData[u] = { msgs[u], sizeof(msgs[u]) };
+  size_t msgsOut = 0;
+  ASSERT_THAT(syncIO.writeMulti(pasynUser, outData, 3, &msgsOut, 1.0),
+              Eq(asynSuccess));
+  ASSERT_THAT(msgsOut, Eq(3u));
+
+  for (int u=0; u<3; ++u)  {
+    char buf[16];  sockaddr_in from {};  socklen_t fromLen = sizeof(from);
+    ssize_t len = recvfrom(peer, buf, sizeof(buf), 0, (sockaddr *)&from, &fromLen);
+    ASSERT_THAT(len, Eq(4));
+    sendto(peer, buf, len, 0, (sockaddr *)&from, fromLen);
+  }
+
+  char bufs[4][16];
+  readData inData[4];
+  size_t nbytesIn[4], msgsIn = 0;
+  for (int u=0; u<4; ++u)  inData[u] = { bufs[u], sizeof(bufs[u]) };
+  for (size_t total = 0; total < 3; total += msgsIn)  {
+    ASSERT_THAT(syncIO.readMulti(pasynUserRcv, inData + total, nbytesIn + total,
+                                 4 - total, &msgsIn, 1.0), Eq(asynSuccess));
+  }
+  for (int u=0; u<3; ++u)  {
+    ASSERT_THAT(nbytesIn[u], Eq(4u));
+    ASSERT_STREQ(bufs[u], msgs[u]);
+  }
+
+  ASSERT_THAT(syncIO.readMulti(pasynUserRcv, inData, nbytesIn, 4, &msgsIn, 0.01),
+              Eq(asynTimeout));
+
+  syncIO.disconnect(pasynUserRcv);
+  syncIO.disconnect(pasynUser);
+  close(peer);
+}
+
+//-----------------------------------------------------------------------------
+TEST(PmemCache, loadsOnlyAnIntactImageForTheSameKey)  {
+  char dirName[] = "/tmp/pmemCacheTestXXXXXX";
+  ASSERT_THAT(mkdtemp(dirName), NotNull());
+  string dir(dirName);
+
+  // region spans 3 blocks (partial 1st and last ones)
+  vector<uint8_t> image(0x300), loaded;
+  for (size_t u=0; u<image.size(); ++u)  image[u] = u * 7;
+  string path;
+  {
+    PmemCache cache("10.0.0.1:2005", 1, 0x180, image.size(), 0x200);
+    ASSERT_THAT(cache.open(dir), Eq(asynSuccess));
+    ASSERT_FALSE(cache.load(loaded));  // new file
+    ASSERT_THAT(cache.store(image), Eq(3u));
+    image[0x250] ^= 0xFF;
+    ASSERT_THAT(cache.store(image), Eq(1u));  // only the 2nd block chgd
+    path = cache.getPath();
+  }
+  {
+    PmemCache cache("10.0.0.1:2005", 1, 0x180, image.size(), 0x200);
+    ASSERT_THAT(cache.open(dir), Eq(asynSuccess));
+    ASSERT_TRUE(cache.load(loaded));
+    ASSERT_THAT(loaded, Eq(image));
+
+    // corrupt the file: the image must not be trusted
+    cache.image[0x10] ^= 0xFF;
+    ASSERT_FALSE(cache.load(loaded));
+    ASSERT_THAT(cache.store(image), Eq(3u));
+    cache.invalidate();
+    ASSERT_FALSE(cache.load(loaded));
+    cache.store(image);
+  }
+  {
+    // the same region of a different ctlr gets its own file
+    PmemCache cache("10.0.0.2:2005", 1, 0x180, image.size(), 0x200);
+    ASSERT_THAT(cache.open(dir), Eq(asynSuccess));
+    ASSERT_THAT(cache.getPath(), Ne(path));
+    ASSERT_FALSE(cache.load(loaded));
+    unlink(cache.getPath().c_str());
+  }
+
+  unlink(path.c_str());
+  rmdir(dirName);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief When the ctlr comes online, an array with a valid cache file gets
+ *        the cached value instead of being read again.  A ctlr restart or a
+ *        write to the array invalidates the cache file.
+ */
+TEST_F(AnFGPDBDriverUsingIOSyncMock, postsCachedPMEMValueWhenCtlrComesOnline) {
+  char dirName[] = "/tmp/pmemCacheTestXXXXXX";
+  ASSERT_THAT(mkdtemp(dirName), NotNull());
+
+  addParams();
+  testDrv->setPmemCacheDir(dirName);
+  testDrv->completeArrayParamInit();
+
+  ASSERT_THAT(testDrv->pmemCaches.count(testArrayID), Eq(1u));
+  PmemCache &cache = *testDrv->pmemCaches.at(testArrayID);
+  ParamInfo &param = testDrv->params.at(testArrayID);
+
+  // a completed read of the array is saved in the cache
+  vector<uint8_t> image(param.arrayValRead.size());
+  for (size_t u=0; u<image.size(); ++u)  image[u] = u * 3 + 1;
+  cache.store(image);
+
+  auto comesOnline = [&] () {
+    fill(param.arrayValRead.begin(), param.arrayValRead.end(), 0);
+    lock_guard<drvFGPDB> asynLock(*testDrv);
+    testDrv->publishCachedArrays();
+  };
+
+  // connection lost: the cached value is posted and not read again
+  testDrv->resetReadStates();
+  comesOnline();
+  ASSERT_THAT(param.arrayValRead, Eq(image));
+  ASSERT_THAT(param.readState, Eq(ReadState::Pending));
+  ASSERT_THAT(testDrv->activeArrayReads.count(testArrayID), Eq(0u));
+  ASSERT_THAT(testDrv->setAsynParamVal(testArrayID), Eq(asynSuccess));
+
+  // ctlr restarted: the array is read again
+  testDrv->lastRespTime = chrono::system_clock::now();
+  testDrv->checkForRestart(10);
+  comesOnline();
+  ASSERT_THAT(param.arrayValRead, Each(0));
+  ASSERT_THAT(param.readState, Eq(ReadState::Update));
+  ASSERT_THAT(testDrv->activeArrayReads.count(testArrayID), Eq(1u));
+  cache.store(image);  // as if read again
+
+  // a new value written to the array makes the cached one stale
+  vector<epicsInt8> newVal(image.size(), 0x5A);
+  ASSERT_THAT(clientWriteInt8Array(testArrayID, newVal), Eq(asynSuccess));
+  vector<uint8_t> loaded;
+  ASSERT_FALSE(cache.load(loaded));
+
+  unlink(cache.getPath().c_str());
+  rmdir(dirName);
+}